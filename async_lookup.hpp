@@ -0,0 +1,244 @@
+#pragma once
+
+// --- COROUTINE LOOKUPS ---
+// point lookups as C++20 coroutines that suspend after prefetching each child, so one thread
+// keeps many descents in flight and overlaps their cache misses (interleaving in the style of
+// Psaropoulos et al. / Jonathan et al.). Unlike findBatch, which walks a fixed group level by level,
+// a RoundRobinScheduler slot is refilled as soon as its lookup finishes, and the caller can poll()
+// in between its own work.
+//
+// needs -std=c++20. Under C++17 this header is empty and BPT_HAS_COROUTINES is 0, so it can be
+// included unconditionally
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+#define BPT_HAS_COROUTINES 1
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace async_lookup
+{
+    // coroutine frames recycled through a per-thread free list per 64-byte size class. Every lookup
+    // on one tree type has the same frame size, so after the first few a lookup costs no malloc
+    class FramePool
+    {
+        static constexpr size_t CLASS_BYTES = 64;
+        static constexpr size_t NUM_CLASSES = 16; // frames up to 1 KB, larger ones go to operator new
+
+        struct FreeFrame
+        {
+            FreeFrame *next;
+        };
+
+        FreeFrame *free_lists[NUM_CLASSES] = {};
+
+        static size_t class_of(size_t bytes) { return (bytes + CLASS_BYTES - 1) / CLASS_BYTES - 1; }
+
+    public:
+        FramePool() = default;
+        FramePool(const FramePool &) = delete;
+        FramePool &operator=(const FramePool &) = delete;
+
+        ~FramePool()
+        {
+            for (FreeFrame *&list : free_lists)
+            {
+                while (list)
+                {
+                    FreeFrame *next = list->next;
+                    ::operator delete(list);
+                    list = next;
+                }
+            }
+        }
+
+        static FramePool &local()
+        {
+            thread_local FramePool pool;
+            return pool;
+        }
+
+        void *allocate(size_t bytes)
+        {
+            size_t c = class_of(bytes);
+            if (c >= NUM_CLASSES)
+                return ::operator new(bytes);
+            if (FreeFrame *frame = free_lists[c])
+            {
+                free_lists[c] = frame->next;
+                return frame;
+            }
+            return ::operator new((c + 1) * CLASS_BYTES);
+        }
+
+        // a frame freed on another thread joins that thread's list
+        void release(void *mem, size_t bytes)
+        {
+            size_t c = class_of(bytes);
+            if (c >= NUM_CLASSES)
+            {
+                ::operator delete(mem);
+                return;
+            }
+            free_lists[c] = ::new (mem) FreeFrame{free_lists[c]};
+        }
+    };
+
+    // one suspended lookup. Created suspended, every resume() runs one node, found() once done()
+    class LookupTask
+    {
+    public:
+        struct promise_type
+        {
+            bool found = false;
+
+            LookupTask get_return_object() { return LookupTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_value(bool hit) { found = hit; }
+            void unhandled_exception() { std::terminate(); } // lookups don't throw
+
+            static void *operator new(size_t bytes) { return FramePool::local().allocate(bytes); }
+            static void operator delete(void *mem, size_t bytes) { FramePool::local().release(mem, bytes); }
+        };
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+
+        explicit LookupTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+
+    public:
+        LookupTask() = default;
+        LookupTask(LookupTask &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+        LookupTask &operator=(LookupTask &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (handle)
+                    handle.destroy();
+                handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+
+        LookupTask(const LookupTask &) = delete;
+        LookupTask &operator=(const LookupTask &) = delete;
+
+        ~LookupTask()
+        {
+            if (handle)
+                handle.destroy();
+        }
+
+        bool done() const { return !handle || handle.done(); }
+        void resume() { handle.resume(); }
+        bool found() const { return handle.promise().found; }
+    };
+
+    // tree.findSIMD(key, val_out) as a coroutine that suspends after each prefetched child. tree and
+    // val_out must outlive the task, val_out is only written on a hit
+    template <typename Tree, typename KeyType, typename ValueType>
+    LookupTask find_async(Tree &tree, KeyType key, ValueType &val_out)
+    {
+        typename Tree::LookupState state;
+        if (!tree.lookup_begin(key, state))
+            co_return false;
+        bool found = false;
+        while (tree.lookup_step(key, state, val_out, found))
+        {
+            co_await std::suspend_always{};
+        }
+        co_return found;
+    }
+
+    // up to width lookups in flight on the calling thread. submit() parks a lookup under a tag,
+    // poll() resumes each in-flight one once (round robin) and hands finished ones to
+    // on_done(tag, found). Not thread safe, one scheduler per thread
+    class RoundRobinScheduler
+    {
+        struct Slot
+        {
+            LookupTask task;
+            size_t tag;
+        };
+
+        std::vector<Slot> slots;
+        size_t width;
+
+    public:
+        explicit RoundRobinScheduler(size_t max_in_flight) : width(max_in_flight)
+        {
+            if (max_in_flight == 0)
+                throw std::invalid_argument("RoundRobinScheduler needs at least one slot");
+            slots.reserve(max_in_flight);
+        }
+
+        size_t in_flight() const { return slots.size(); }
+        bool full() const { return slots.size() == width; }
+
+        // throws std::length_error when all slots are taken
+        void submit(LookupTask task, size_t tag)
+        {
+            if (full())
+                throw std::length_error("RoundRobinScheduler is full");
+            slots.push_back({std::move(task), tag});
+        }
+
+        // one round, returns the lookups still in flight
+        template <typename OnDone>
+        size_t poll(OnDone &&on_done)
+        {
+            for (size_t i = 0; i < slots.size();)
+            {
+                slots[i].task.resume();
+                if (slots[i].task.done())
+                {
+                    on_done(slots[i].tag, slots[i].task.found());
+                    // the last slot moves in and is resumed next, order doesn't matter for lookups
+                    slots[i] = std::move(slots.back());
+                    slots.pop_back();
+                    continue;
+                }
+                i++;
+            }
+            return slots.size();
+        }
+
+        template <typename OnDone>
+        void drain(OnDone &&on_done)
+        {
+            while (poll(on_done))
+            {
+            }
+        }
+    };
+
+    // same contract as BPlusTree::findBatch: n lookups with up to width of them in flight, a slot
+    // takes the next key as soon as its lookup is done
+    template <typename Tree, typename KeyType, typename ValueType>
+    void find_interleaved(Tree &tree, const KeyType *keys, size_t n, ValueType *out, uint8_t *found,
+                          RoundRobinScheduler &scheduler)
+    {
+        size_t next = 0;
+        auto on_done = [&](size_t tag, bool hit) { found[tag] = hit; };
+        while (next < n || scheduler.in_flight())
+        {
+            while (next < n && !scheduler.full())
+            {
+                scheduler.submit(find_async(tree, keys[next], out[next]), next);
+                next++;
+            }
+            scheduler.poll(on_done);
+        }
+    }
+}
+
+#else
+#define BPT_HAS_COROUTINES 0
+#endif
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// --- BENCHMARK TIMING ---
+// CycleTimer reads the TSC with serializing fences (x86: lfence/rdtsc/lfence to start,
+// rdtscp/lfence to stop; aarch64: isb + cntvct_el0; elsewhere steady_clock), which is a few ns
+// instead of the 20-40 ns of two clock::now() calls. calibrate() measures ticks per ns against
+// steady_clock and the cost of an empty start/stop pair, which is subtracted from every sample.
+class CycleTimer
+{
+    double ns_per_tick = 1.0;
+    uint64_t overhead_ticks = 0;
+
+public:
+    static inline uint64_t start()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_lfence();
+        uint64_t t = __rdtsc();
+        _mm_lfence();
+        return t;
+#elif defined(__aarch64__)
+        uint64_t t;
+        asm volatile("isb; mrs %0, cntvct_el0" : "=r"(t)::"memory");
+        return t;
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    static inline uint64_t stop()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned aux;
+        uint64_t t = __rdtscp(&aux);
+        _mm_lfence();
+        return t;
+#elif defined(__aarch64__)
+        uint64_t t;
+        asm volatile("isb; mrs %0, cntvct_el0; isb" : "=r"(t)::"memory");
+        return t;
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    // busy-waits ~calibration_ms once, call before the timed runs
+    void calibrate(int calibration_ms = 50)
+    {
+        auto wall_start = std::chrono::steady_clock::now();
+        uint64_t tick_start = start();
+        while (std::chrono::steady_clock::now() - wall_start < std::chrono::milliseconds(calibration_ms)) {}
+        uint64_t tick_end = stop();
+        auto wall_end = std::chrono::steady_clock::now();
+        double wall_ns = std::chrono::duration<double, std::nano>(wall_end - wall_start).count();
+        ns_per_tick = wall_ns / std::max<uint64_t>(1, tick_end - tick_start);
+
+        // cheapest empty measurement = what the timer itself adds to a sample
+        uint64_t best = UINT64_MAX;
+        for (int i = 0; i < 10000; i++)
+        {
+            uint64_t t0 = start();
+            uint64_t t1 = stop();
+            best = std::min(best, t1 - t0);
+        }
+        overhead_ticks = best;
+    }
+
+    // elapsed ns between a start() and a stop(), timer overhead removed
+    double to_ns(uint64_t t0, uint64_t t1) const
+    {
+        uint64_t ticks = t1 - t0;
+        ticks = ticks > overhead_ticks ? ticks - overhead_ticks : 0;
+        return ticks * ns_per_tick;
+    }
+
+    double get_ns_per_tick() const { return ns_per_tick; }
+    double get_overhead_ns() const { return overhead_ticks * ns_per_tick; }
+};
+
+// --- LATENCY HISTOGRAM ---
+// HDR-style log-linear buckets: values below 128 are exact, above that every power of two is
+// split into 64 buckets (< 1.6% relative error). Fixed ~18 KB however many samples go in,
+// values past 2^40 ns (~18 min) land in the last bucket.
+class LatencyHistogram
+{
+    static constexpr int SUB_BITS = 7;
+    static constexpr uint64_t SUB_COUNT = 1ULL << SUB_BITS; // exact range
+    static constexpr uint64_t HALF_COUNT = SUB_COUNT / 2;   // buckets per power of two above it
+    static constexpr int MAX_BITS = 40;
+    static constexpr size_t NUM_BUCKETS = SUB_COUNT + (MAX_BITS - SUB_BITS + 1) * HALF_COUNT;
+
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t max_value = 0;
+    long double sum = 0;
+
+    static size_t bucket_of(uint64_t v)
+    {
+        if (v < SUB_COUNT)
+            return (size_t)v;
+        int shift = (63 - __builtin_clzll(v)) - (SUB_BITS - 1);
+        size_t idx = SUB_COUNT + (shift - 1) * HALF_COUNT + ((v >> shift) - HALF_COUNT);
+        return std::min(idx, NUM_BUCKETS - 1);
+    }
+
+    // middle of the value range a bucket covers
+    static uint64_t value_of(size_t idx)
+    {
+        if (idx < SUB_COUNT)
+            return idx;
+        int shift = (int)((idx - SUB_COUNT) / HALF_COUNT) + 1;
+        uint64_t sub = (idx - SUB_COUNT) % HALF_COUNT + HALF_COUNT;
+        return (sub << shift) + ((1ULL << shift) >> 1);
+    }
+
+public:
+    LatencyHistogram() : counts(NUM_BUCKETS, 0) {}
+
+    // `count` operations that each took value ns (count > 1 for batch-timed samples)
+    void record(uint64_t value, uint64_t count = 1)
+    {
+        counts[bucket_of(value)] += count;
+        total += count;
+        sum += (long double)value * count;
+        max_value = std::max(max_value, value);
+    }
+
+    void merge(const LatencyHistogram &other)
+    {
+        for (size_t i = 0; i < NUM_BUCKETS; i++)
+        {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        max_value = std::max(max_value, other.max_value);
+    }
+
+    // p in [0, 1]
+    uint64_t percentile(double p) const
+    {
+        if (total == 0)
+            return 0;
+        uint64_t rank = std::min<uint64_t>(total - 1, (uint64_t)(p * total));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; i++)
+        {
+            seen += counts[i];
+            if (seen > rank)
+                return std::min(value_of(i), max_value);
+        }
+        return max_value;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return max_value; }
+    uint64_t mean() const { return total ? (uint64_t)(sum / total) : 0; }
+};
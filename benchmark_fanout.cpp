@@ -0,0 +1,293 @@
+#include "bplustree.hpp"
+#include "bench_timer.hpp"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <string>
+#include <sstream>
+#include <utility>
+
+using namespace std;
+
+// usage: benchmark_fanout [--sizes 100000,1000000,10000000] [--fanouts 16,32,64,128,256,512,1024]
+//                         [--types i32/i32,i64/i64,i64/b32] [--lookups N] [--timing-batch N]
+//                         [--csv benchmark_fanout.csv]
+// every (type, M, N) combination builds a fresh tree by random inserts, then runs --lookups hits
+// through findLinear / findBinary / findSIMD. Keys are a bijective hash of 0..N-1, generated on the fly,
+// so N = 1e9 needs memory for the tree only (the Bytes/Key column, ~11-20 B/key for i32/i32)
+
+const size_t ARENA_INITIAL_SIZE = 64ULL * 1024 * 1024;   // 64 MB, grows in chunks from here
+const size_t ARENA_MAX_SIZE = 256ULL * 1024 * 1024 * 1024; // 256 GB, only mapped as the tree grows
+
+// fanouts compiled in, --fanouts picks from these
+using Fanouts = integer_sequence<int, 16, 32, 64, 128, 256, 512, 1024>;
+
+// 32-byte value, for payload-heavy leaves
+struct Bytes32 {
+    uint64_t words[4];
+    Bytes32() : words{0, 0, 0, 0} {}
+    explicit Bytes32(uint64_t v) : words{v, 0, 0, 0} {}
+};
+
+template<typename T> const char* type_name();
+template<> const char* type_name<int32_t>() { return "i32"; }
+template<> const char* type_name<int64_t>() { return "i64"; }
+template<> const char* type_name<Bytes32>() { return "b32"; }
+
+struct FanoutResult {
+    string key_type;
+    string value_type;
+    int fanout;
+    size_t keys;
+    string op;
+    double avg_ns;
+    long long p50_ns;
+    long long p99_ns;
+    double mops;
+    int height;
+    double bytes_per_key;
+    double leaf_fill;
+};
+
+CycleTimer timer;
+size_t timing_batch = 16;
+
+// splitmix64 finalizer: a bijection on 64 bits, so distinct i give distinct 64-bit keys
+inline uint64_t mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// positive keys; 32-bit keys can repeat once N nears 2^31 (inserts overwrite, lookups still hit)
+template<typename K>
+inline K key_of(uint64_t i) {
+    return (K)(mix(i) >> (65 - 8 * sizeof(K)));
+}
+
+template<typename Tree, typename K, typename V, typename Find>
+FanoutResult time_lookups(const char* op, Tree& tree, size_t n, size_t lookups, Find find,
+                          const FanoutResult& base) {
+    LatencyHistogram hist;
+    uint64_t state = 0x5EED;
+    size_t found = 0;
+    auto wall_start = chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; i += timing_batch) {
+        size_t batch = min(timing_batch, lookups - i);
+        // keys drawn before the timed window
+        K keys[256];
+        for (size_t j = 0; j < batch; j++) {
+            state = mix(state);
+            keys[j] = key_of<K>(state % n);
+        }
+        uint64_t t0 = CycleTimer::start();
+        for (size_t j = 0; j < batch; j++) {
+            V val;
+            found += find(tree, keys[j], val);
+        }
+        uint64_t t1 = CycleTimer::stop();
+        hist.record((uint64_t)(timer.to_ns(t0, t1) / batch), batch);
+    }
+    auto wall_end = chrono::steady_clock::now();
+    if (found != lookups) {
+        cerr << "  " << op << ": " << (lookups - found) << " keys missing!" << endl;
+    }
+    double wall_ns = chrono::duration<double, nano>(wall_end - wall_start).count();
+    FanoutResult res = base;
+    res.op = op;
+    res.avg_ns = (double)hist.mean();
+    res.p50_ns = (long long)hist.percentile(0.50);
+    res.p99_ns = (long long)hist.percentile(0.99);
+    res.mops = lookups * 1000.0 / wall_ns;
+    return res;
+}
+
+template<typename K, typename V, int M>
+void run_combination(size_t n, size_t lookups, vector<FanoutResult>& results) {
+    cout << "  " << type_name<K>() << "/" << type_name<V>() << "  M=" << M << "  N=" << n << "..." << flush;
+
+    Arena arena(ARENA_INITIAL_SIZE, ARENA_MAX_SIZE, Arena::HugePages::Transparent);
+    BPlusTree<K, V, M> tree(arena);
+
+    // insert: whole-build throughput, per-key latency from the same batches
+    LatencyHistogram insert_hist;
+    auto wall_start = chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i += timing_batch) {
+        size_t batch = min(timing_batch, n - i);
+        uint64_t t0 = CycleTimer::start();
+        for (size_t j = i; j < i + batch; j++) {
+            tree.insert(key_of<K>(j), V(j));
+        }
+        uint64_t t1 = CycleTimer::stop();
+        insert_hist.record((uint64_t)(timer.to_ns(t0, t1) / batch), batch);
+    }
+    auto wall_end = chrono::steady_clock::now();
+
+    BPlusTreeStats stats = tree.stats();
+    FanoutResult base;
+    base.key_type = type_name<K>();
+    base.value_type = type_name<V>();
+    base.fanout = M;
+    base.keys = tree.size();
+    base.height = stats.height;
+    base.bytes_per_key = stats.bytes_per_key;
+    base.leaf_fill = stats.leaf_fill_factor;
+
+    FanoutResult ins = base;
+    ins.op = "insert";
+    ins.avg_ns = (double)insert_hist.mean();
+    ins.p50_ns = (long long)insert_hist.percentile(0.50);
+    ins.p99_ns = (long long)insert_hist.percentile(0.99);
+    ins.mops = n * 1000.0 / chrono::duration<double, nano>(wall_end - wall_start).count();
+    results.push_back(ins);
+
+    using Tree = BPlusTree<K, V, M>;
+    results.push_back(time_lookups<Tree, K, V>("findLinear", tree, n, lookups,
+        [](Tree& t, K k, V& v) { return t.findLinear(k, v); }, base));
+    results.push_back(time_lookups<Tree, K, V>("findBinary", tree, n, lookups,
+        [](Tree& t, K k, V& v) { return t.findBinary(k, v); }, base));
+    results.push_back(time_lookups<Tree, K, V>("findSIMD", tree, n, lookups,
+        [](Tree& t, K k, V& v) { return t.findSIMD(k, v); }, base));
+
+    cout << " height " << base.height << ", " << fixed << setprecision(1) << base.bytes_per_key << " B/key"
+         << defaultfloat << endl;
+}
+
+// every selected compiled-in fanout for one key / value pair
+template<typename K, typename V, int... Ms>
+void run_fanouts(const vector<int>& fanouts, size_t n, size_t lookups, vector<FanoutResult>& results,
+                 integer_sequence<int, Ms...>) {
+    auto selected = [&](int m) { return find(fanouts.begin(), fanouts.end(), m) != fanouts.end(); };
+    ((selected(Ms) ? run_combination<K, V, Ms>(n, lookups, results) : void()), ...);
+}
+
+template<typename K, typename V>
+void run_type(const vector<string>& types, const vector<int>& fanouts, const vector<size_t>& sizes,
+              size_t lookups, vector<FanoutResult>& results) {
+    string name = string(type_name<K>()) + "/" + type_name<V>();
+    if (find(types.begin(), types.end(), name) == types.end()) return;
+    for (size_t n : sizes) {
+        run_fanouts<K, V>(fanouts, n, min(lookups, max<size_t>(n, 1)), results, Fanouts());
+    }
+}
+
+void print_table(const vector<FanoutResult>& results) {
+    cout << "\n" << string(124, '=') << endl;
+    cout << left << setw(10) << "Types"
+         << setw(8) << "M"
+         << setw(14) << "Keys"
+         << setw(12) << "Op"
+         << setw(10) << "Avg(ns)"
+         << setw(10) << "P50(ns)"
+         << setw(10) << "P99(ns)"
+         << setw(10) << "Mops/s"
+         << setw(8) << "Height"
+         << setw(12) << "Bytes/Key"
+         << setw(10) << "LeafFill" << endl;
+    cout << string(124, '-') << endl;
+    for (const auto& res : results) {
+        cout << left << setw(10) << (res.key_type + "/" + res.value_type)
+             << setw(8) << res.fanout
+             << setw(14) << res.keys
+             << setw(12) << res.op
+             << fixed << setprecision(1) << setw(10) << res.avg_ns
+             << setw(10) << res.p50_ns
+             << setw(10) << res.p99_ns
+             << setprecision(2) << setw(10) << res.mops
+             << setw(8) << res.height
+             << setprecision(1) << setw(12) << res.bytes_per_key
+             << setprecision(2) << setw(10) << res.leaf_fill << defaultfloat << endl;
+    }
+    cout << string(124, '=') << endl;
+}
+
+void write_csv(const string& path, const vector<FanoutResult>& results) {
+    ofstream out(path);
+    out << "key_type,value_type,fanout,keys,op,avg_ns,p50_ns,p99_ns,mops,height,bytes_per_key,leaf_fill\n";
+    for (const auto& res : results) {
+        out << res.key_type << ',' << res.value_type << ',' << res.fanout << ',' << res.keys << ','
+            << res.op << ',' << res.avg_ns << ',' << res.p50_ns << ',' << res.p99_ns << ',' << res.mops << ','
+            << res.height << ',' << res.bytes_per_key << ',' << res.leaf_fill << '\n';
+    }
+}
+
+template<int... Ms>
+bool is_compiled_fanout(int m, integer_sequence<int, Ms...>) {
+    return ((m == Ms) || ...);
+}
+
+vector<string> split_list(const string& arg) {
+    vector<string> items;
+    stringstream ss(arg);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+int main(int argc, char** argv)
+{
+    vector<size_t> sizes = {100000, 1000000, 10000000};
+    vector<int> fanouts = {16, 32, 64, 128, 256, 512, 1024};
+    vector<string> types = {"i32/i32", "i64/i64", "i64/b32"};
+    size_t lookups = 1000000;
+    string csv_path = "benchmark_fanout.csv";
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        string next = i + 1 < argc ? argv[i + 1] : "";
+        if (arg == "--sizes") {
+            sizes.clear();
+            for (auto& s : split_list(next)) sizes.push_back((size_t)stod(s)); // accepts 1e9
+            i++;
+        } else if (arg == "--fanouts") {
+            fanouts.clear();
+            for (auto& f : split_list(next)) fanouts.push_back(stoi(f));
+            i++;
+        } else if (arg == "--types") {
+            types = split_list(next);
+            i++;
+        } else if (arg == "--lookups") {
+            lookups = (size_t)stod(next);
+            i++;
+        } else if (arg == "--timing-batch") {
+            timing_batch = min<size_t>(256, max(1, stoi(next)));
+            i++;
+        } else if (arg == "--csv") {
+            csv_path = next;
+            i++;
+        } else {
+            cerr << "unknown argument " << arg << endl;
+            return 1;
+        }
+    }
+
+    for (int m : fanouts) {
+        if (!is_compiled_fanout(m, Fanouts())) {
+            cerr << "fanout " << m << " is not compiled in (16, 32, 64, 128, 256, 512, 1024)" << endl;
+            return 1;
+        }
+    }
+
+    timer.calibrate();
+    cout << "========================================" << endl;
+    cout << "FANOUT STUDY" << endl;
+    cout << "Node search ISA: " << simd_isa_name(active_simd_isa()) << ", " << lookups
+         << " lookups per run, " << timing_batch << " op(s) per sample" << endl;
+    cout << "========================================\n" << endl;
+
+    vector<FanoutResult> results;
+    run_type<int32_t, int32_t>(types, fanouts, sizes, lookups, results);
+    run_type<int64_t, int64_t>(types, fanouts, sizes, lookups, results);
+    run_type<int64_t, Bytes32>(types, fanouts, sizes, lookups, results);
+
+    print_table(results);
+    write_csv(csv_path, results);
+    cout << "CSV written to " << csv_path << endl;
+    return 0;
+}
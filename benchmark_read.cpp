@@ -1,4 +1,12 @@
 #include "bplustree.hpp"
+#include "static_bplustree.hpp"
+#include "compressed_bplustree.hpp"
+#include "concurrent_bplustree.hpp"
+#include "string_bplustree.hpp"
+#include "async_lookup.hpp"
+#include "bench_timer.hpp"
+#include "perf_counters.hpp"
+#include "workload.hpp"
 #include <iostream>
 #include <vector>
 #include <algorithm>
@@ -8,12 +16,14 @@
 #include <unordered_map>
 #include <iomanip>
 #include <string>
+#include <memory>
+#include <cstdio>
+#include <sstream>
 
 using namespace std;
 
-//  global arena
-Arena* global_arena = nullptr;
-const size_t ARENA_SIZE = 1ULL * 1024 * 1024 * 1024; // 1 GB
+const size_t ARENA_INITIAL_SIZE = 64ULL * 1024 * 1024;  // 64 MB, grows in chunks from here
+const size_t ARENA_MAX_SIZE = 64ULL * 1024 * 1024 * 1024; // 64 GB, only mapped as the trees grow
 
 struct BenchmarkResult {
     string name;
@@ -25,6 +35,9 @@ struct BenchmarkResult {
     long long p99_ns;
     long long p999_ns;
     long long total_ms;
+    double mops; // throughput over wall-clock time, timer overhead included
+    long long ops;
+    PerfSample perf; // whole timed loop, empty without --perf
 };
 
 // Heavy work to wake up CPU cores and caches
@@ -45,70 +58,287 @@ void pre_warm_cpu() {
         // Simulate some DP-like dependency chain
         for (size_t i = 2; i < data.size(); i++) {
             data[i] = (data[i-1] + data[i-2]) % 123456;
-            counter += data[i];
+            counter = counter + data[i];
         }
     }
     cout << "Pre-warming complete. Result: " << counter << endl;
     cout << "----------------------------------------\n" << endl;
 }
 
+// calibrated once in main, shared by every run
+CycleTimer timer;
+// ops per timed sample (--timing-batch), 1 = every lookup timed on its own
+size_t timing_batch = 1;
+
+// hardware counter group (--perf), null when off or unavailable
+unique_ptr<PerfCounterGroup> perf_group;
+
+BenchmarkResult make_result(string name, string strategy, const LatencyHistogram& hist, double wall_ns, const PerfSample& perf) {
+    return {
+        name,
+        strategy,
+        (long long)hist.mean(),
+        (long long)hist.max(),
+        (long long)hist.percentile(0.50),
+        (long long)hist.percentile(0.90),
+        (long long)hist.percentile(0.99),
+        (long long)hist.percentile(0.999),
+        (long long)(wall_ns / 1e6),
+        hist.count() * 1000.0 / wall_ns,
+        (long long)hist.count(),
+        perf
+    };
+}
+
+// times timing_batch lookups per sample with rdtscp and records the per-lookup latency into a
+// fixed-size histogram (no per-sample storage, so N can be as large as the key set)
 template<typename Func>
 BenchmarkResult run_benchmark(string name, string strategy, int N, const vector<int>& keys, Func lookup_func) {
-    long long total_time = 0;
-    long long max_time = 0;
-    long long found_count = 0; // Changed to long long to prevent overflow although int is enough for N=1M
-    vector<long long> latencies;
-    latencies.reserve(N);
+    LatencyHistogram hist;
+    long long found_count = 0;
+
+    if (perf_group) perf_group->start();
+    auto benchmark_start = chrono::steady_clock::now();
+
+    for (size_t i = 0; i < (size_t)N; i += timing_batch) {
+        size_t n = min(timing_batch, (size_t)N - i);
+        uint64_t start = CycleTimer::start();
+        for (size_t j = 0; j < n; j++) {
+            found_count += lookup_func(keys[i + j]);
+        }
+        uint64_t end = CycleTimer::stop();
+        hist.record((uint64_t)(timer.to_ns(start, end) / n), n);
+    }
+
+    auto benchmark_end = chrono::steady_clock::now();
+    PerfSample perf = perf_group ? perf_group->stop() : PerfSample();
+
+    // keep the lookups observable so they can't be optimized away
+    volatile long long keep_alive = found_count;
+    (void)keep_alive;
+
+    return make_result(name, strategy, hist, chrono::duration<double, nano>(benchmark_end - benchmark_start).count(), perf);
+}
+
+// Batched variant: times one call per batch of `batch` keys and records the
+// amortized per-key latency (batch time / batch size) for each key of the batch
+template<typename Func>
+BenchmarkResult run_batch_benchmark(string name, string strategy, int N, const vector<int>& keys, size_t batch, Func batch_func) {
+    LatencyHistogram hist;
+    long long found_count = 0;
+
+    if (perf_group) perf_group->start();
+    auto benchmark_start = chrono::steady_clock::now();
+
+    for (size_t i = 0; i < (size_t)N; i += batch) {
+        size_t n = min(batch, (size_t)N - i);
+        uint64_t start = CycleTimer::start();
+        found_count += batch_func(&keys[i], n);
+        uint64_t end = CycleTimer::stop();
+        hist.record((uint64_t)(timer.to_ns(start, end) / n), n);
+    }
+
+    auto benchmark_end = chrono::steady_clock::now();
+    PerfSample perf = perf_group ? perf_group->stop() : PerfSample();
+
+    volatile long long keep_alive = found_count;
+    (void)keep_alive;
+
+    return make_result(name, strategy, hist, chrono::duration<double, nano>(benchmark_end - benchmark_start).count(), perf);
+}
+
+// findSIMD vs findBranchless vs findBinary for one key type. Keys are derived from the int workload through a
+// strictly increasing mapping, so every width sees the same tree shape and hit pattern
+template<typename K, typename ToKey>
+void run_key_width_benchmark(string label, Arena& arena, int N, const vector<int>& insert_keys,
+                             const vector<int>& query_keys, ToKey to_key, vector<BenchmarkResult>& results) {
+    BPlusTree<K, int> tree(arena);
+    for (int i = 0; i < N; i++) {
+        tree.insert(to_key(insert_keys[i]), insert_keys[i]);
+    }
+
+    results.push_back(run_benchmark("B+ Tree (" + label + ")", "SIMD Read", N, query_keys, [&](int key) {
+        int val;
+        return tree.findSIMD(to_key(key), val);
+    }));
+    results.push_back(run_benchmark("B+ Tree (" + label + ")", "Branchless Read", N, query_keys, [&](int key) {
+        int val;
+        return tree.findBranchless(to_key(key), val);
+    }));
+    results.push_back(run_benchmark("B+ Tree (" + label + ")", "Binary Read", N, query_keys, [&](int key) {
+        int val;
+        return tree.findBinary(to_key(key), val);
+    }));
+}
+
+// same int workload in a tree with fanout M and the given intra-node layout
+template<int M, typename Layout>
+void run_layout_benchmark(string label, Arena& arena, int N, const vector<int>& insert_keys,
+                          const vector<int>& query_keys, vector<BenchmarkResult>& results) {
+    BPlusTree<int, int, M, M, Layout> tree(arena);
+    for (int i = 0; i < N; i++) {
+        tree.insert(insert_keys[i], insert_keys[i]);
+    }
 
-    auto benchmark_start = chrono::high_resolution_clock::now();
+    results.push_back(run_benchmark(label + " (M=" + to_string(M) + ")", "SIMD Read", N, query_keys, [&](int key) {
+        int val;
+        return tree.findSIMD(key, val);
+    }));
+}
 
+// URL-like keys (long shared prefixes) through the string tree vs a B+ tree of std::string and
+// std::map. Query ints index into the key table so the string building stays outside the timing
+void run_string_key_benchmark(Arena& arena, int N, const vector<int>& insert_keys,
+                              const vector<int>& query_keys, vector<BenchmarkResult>& results) {
+    auto to_url = [](int k) {
+        return "https://www.site" + to_string(k % 97) + ".example.com/catalog/" + to_string(k % 31) +
+               "/item/" + to_string(k);
+    };
+    vector<string> urls(N);
     for (int i = 0; i < N; i++) {
-        auto start = chrono::high_resolution_clock::now();
-        bool found = lookup_func(keys[i]);
-        auto end = chrono::high_resolution_clock::now();
+        urls[i] = to_url(query_keys[i]);
+    }
+    vector<int> order(N);
+    for (int i = 0; i < N; i++) order[i] = i;
+
+    StringBPlusTree<int> string_tree;
+    BPlusTree<string, int, 64> generic_tree(arena);
+    map<string, int> stl_map;
+    size_t url_bytes = 0;
+    for (int k : insert_keys) {
+        string url = to_url(k);
+        url_bytes += url.size();
+        string_tree.insert(url, k);
+        generic_tree.insert(url, k);
+        stl_map[url] = k;
+    }
+    cout << "    string tree: " << (string_tree.memory_bytes() / (1024.0 * 1024)) << " MB for "
+         << (url_bytes / (1024.0 * 1024)) << " MB of keys, " << string_tree.height() << " levels" << endl;
 
-        if (found) found_count++;
+    results.push_back(run_benchmark("String B+ Tree (heads)", "String Read", N, order, [&](int i) {
+        int val;
+        return string_tree.findSIMD(urls[i], val);
+    }));
+    results.push_back(run_benchmark("B+ Tree (std::string)", "String Read", N, order, [&](int i) {
+        int val;
+        return generic_tree.findBinary(urls[i], val);
+    }));
+    results.push_back(run_benchmark("std::map", "String Read", N, order, [&](int i) {
+        return stl_map.find(urls[i]) != stl_map.end();
+    }));
+}
 
-        long long latency = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
-        latencies.push_back(latency);
-        total_time += latency;
-        if (latency > max_time) {
-            max_time = latency;
+// point lookups with a long untimed range scan every scan_every lookups: the scans stream leaves
+// through the caches and push out the upper levels that every lookup crosses (P99 is what moves)
+BenchmarkResult run_scan_mix_benchmark(string name, BPlusTree<int, int>& tree, int N, const vector<int>& keys,
+                                       int scan_every, int scan_span) {
+    LatencyHistogram hist;
+    long long found_count = 0;
+    long long scan_sum = 0;
+
+    if (perf_group) perf_group->start();
+    auto benchmark_start = chrono::steady_clock::now();
+
+    for (size_t i = 0; i < (size_t)N; i += timing_batch) {
+        if (i % scan_every < timing_batch) {
+            tree.scan(keys[i], keys[i] + scan_span, [&](int, int v) { scan_sum += v; });
         }
-        
-        // Prevent dead code elimination of the 'found' bool
-        // This is a minimal side effect (asm volatile) to force compiler to value 'found'
-        // But cleaner is to just use found_count at the end.
+        size_t n = min(timing_batch, (size_t)N - i);
+        uint64_t start = CycleTimer::start();
+        for (size_t j = 0; j < n; j++) {
+            int val;
+            found_count += tree.findSIMD(keys[i + j], val);
+        }
+        uint64_t end = CycleTimer::stop();
+        hist.record((uint64_t)(timer.to_ns(start, end) / n), n);
     }
 
-    auto benchmark_end = chrono::high_resolution_clock::now();
-    
-    // Use found_count to prevent optimization
-    // We can just print it or add it to result. 
-    // Let's print it to stderr so it doesn't mess up table but ensures usage.
-    // Or simpler: put it in volatile
-    volatile long long keep_alive = found_count; 
+    auto benchmark_end = chrono::steady_clock::now();
+    PerfSample perf = perf_group ? perf_group->stop() : PerfSample();
+
+    volatile long long keep_alive = found_count + scan_sum;
     (void)keep_alive;
 
-    sort(latencies.begin(), latencies.end());
-    
-    return {
-        name,
-        strategy,
-        total_time / N,
-        max_time,
-        latencies[(size_t)(N * 0.50)], // p50
-        latencies[(size_t)(N * 0.90)], // p90
-        latencies[(size_t)(N * 0.99)], // p99
-        latencies[(size_t)(N * 0.999)], // p99.9
-        chrono::duration_cast<chrono::milliseconds>(benchmark_end - benchmark_start).count()
-    };
+    // wall time includes the scans, Mops/s is not comparable with the other strategies
+    return make_result(name, "Scan+Point", hist, chrono::duration<double, nano>(benchmark_end - benchmark_start).count(), perf);
+}
+
+// B+ tree with a 10 bit/key blocked Bloom filter in front of the descents
+using BloomTree = BPlusTree<int, int, 256, 256, SortedLayout, BloomFilter<10>>;
+
+// one query stream (skewed, with misses, or a trace) against the tree, its frozen copy and the STL baselines
+void run_workload_benchmark(string strategy, const vector<int>& queries, BPlusTree<int, int>& tree,
+                            BloomTree& bloom_tree, StaticBPlusTree<int, int>& frozen, map<int, int>& stl_map,
+                            unordered_map<int, int>& stl_unordered_map, vector<BenchmarkResult>& results) {
+    int n = (int)queries.size();
+    results.push_back(run_benchmark("B+ Tree (SIMD)", strategy, n, queries, [&](int key) {
+        int val;
+        return tree.findSIMD(key, val);
+    }));
+    results.push_back(run_benchmark("B+ Tree (Bloom)", strategy, n, queries, [&](int key) {
+        int val;
+        return bloom_tree.findSIMD(key, val);
+    }));
+    results.push_back(run_benchmark("Static S+Tree", strategy, n, queries, [&](int key) {
+        int val;
+        return frozen.findSIMD(key, val);
+    }));
+    results.push_back(run_benchmark("std::map", strategy, n, queries, [&](int key) {
+        return stl_map.find(key) != stl_map.end();
+    }));
+    results.push_back(run_benchmark("std::unordered_map", strategy, n, queries, [&](int key) {
+        return stl_unordered_map.find(key) != stl_unordered_map.end();
+    }));
+}
+
+// timestamp-like appends (always right of the last key) into fresh containers, then reads skewed
+// towards the newest keys. Query ints index into the key tables so the int64 keys stay outside the timing
+void run_append_benchmark(Arena& arena, int N, workload::QuerySpec recent_spec, mt19937& gen,
+                          vector<BenchmarkResult>& results) {
+    const int64_t start_ns = 1700000000LL * 1000000000LL;
+    vector<int64_t> stream = workload::append_stream<int64_t>(N, start_ns, 1000, 500, gen);
+    vector<int> order(N);
+    for (int i = 0; i < N; i++) order[i] = i;
+
+    BPlusTree<int64_t, int> tree(arena);
+    map<int64_t, int> stl_map;
+    unordered_map<int64_t, int> stl_unordered_map;
+    stl_unordered_map.reserve(N);
+
+    results.push_back(run_benchmark("B+ Tree (int64)", "Append Insert", N, order, [&](int i) {
+        tree.insert(stream[i], i);
+        return true;
+    }));
+    results.push_back(run_benchmark("std::map", "Append Insert", N, order, [&](int i) {
+        stl_map[stream[i]] = i;
+        return true;
+    }));
+    results.push_back(run_benchmark("std::unordered_map", "Append Insert", N, order, [&](int i) {
+        stl_unordered_map[stream[i]] = i;
+        return true;
+    }));
+
+    // newest first: Zipf rank 0 is the latest append
+    vector<int64_t> recency(stream.rbegin(), stream.rend());
+    recent_spec.dist = workload::Distribution::Zipf;
+    vector<int64_t> queries = workload::make_queries(recency, N, recent_spec, stream.front(), stream.back(), gen);
+
+    results.push_back(run_benchmark("B+ Tree (int64)", "Append Recent Read", N, order, [&](int i) {
+        int val;
+        return tree.findSIMD(queries[i], val);
+    }));
+    results.push_back(run_benchmark("std::map", "Append Recent Read", N, order, [&](int i) {
+        return stl_map.find(queries[i]) != stl_map.end();
+    }));
+    results.push_back(run_benchmark("std::unordered_map", "Append Recent Read", N, order, [&](int i) {
+        return stl_unordered_map.find(queries[i]) != stl_unordered_map.end();
+    }));
 }
 
 void print_table(const vector<BenchmarkResult>& results) {
-    // 20 + 20 + 6*12 + 10 = ~122
-    cout << "\n" << string(130, '=') << endl;
-    cout << left << setw(20) << "Container" 
+    // 24 + 20 + 8*12 = ~140
+    cout << "\n" << string(146, '=') << endl;
+    cout << left << setw(24) << "Container" 
          << setw(20) << "Strategy" 
          << setw(12) << "Avg(ns)" 
          << setw(12) << "P50(ns)" 
@@ -116,11 +346,12 @@ void print_table(const vector<BenchmarkResult>& results) {
          << setw(12) << "P99(ns)" 
          << setw(12) << "P99.9(ns)" 
          << setw(12) << "Max(ns)" 
-         << setw(12) << "Total(ms)" << endl;
-    cout << string(130, '-') << endl;
+         << setw(12) << "Total(ms)"
+         << setw(12) << "Mops/s" << endl;
+    cout << string(146, '-') << endl;
 
     for (const auto& res : results) {
-        cout << left << setw(20) << res.name 
+        cout << left << setw(24) << res.name 
              << setw(20) << res.strategy 
              << setw(12) << res.avg_ns
              << setw(12) << res.p50_ns
@@ -128,25 +359,109 @@ void print_table(const vector<BenchmarkResult>& results) {
              << setw(12) << res.p99_ns
              << setw(12) << res.p999_ns
              << setw(12) << res.max_ns
-             << setw(12) << res.total_ms << endl;
+             << setw(12) << res.total_ms
+             << fixed << setprecision(2) << setw(12) << res.mops << defaultfloat << endl;
     }
-    cout << string(130, '=') << endl;
+    cout << string(146, '=') << endl;
 }
 
-int main()
+// per-op hardware counters next to the average latency, only rows that were counted
+void print_perf_table(const vector<BenchmarkResult>& results) {
+    const PerfEvent columns[] = {PerfEvent::L1DMisses, PerfEvent::LLCMisses, PerfEvent::DTLBMisses,
+                                 PerfEvent::BranchMisses, PerfEvent::Instructions, PerfEvent::Cycles};
+    const char* headers[] = {"L1D-miss", "LLC-miss", "dTLB-miss", "Br-miss", "Instr", "Cycles"};
+
+    // 24 + 20 + 12 + 7*12 = 140
+    cout << "\nHARDWARE COUNTERS (per op, timer included: raise --timing-batch to amortize it)" << endl;
+    cout << string(140, '=') << endl;
+    cout << left << setw(24) << "Container" << setw(20) << "Strategy" << setw(12) << "Avg(ns)";
+    for (const char* h : headers) cout << setw(12) << h;
+    cout << setw(12) << "IPC" << endl;
+    cout << string(140, '-') << endl;
+
+    for (const auto& res : results) {
+        if (!res.perf.any() || res.ops == 0) continue;
+        cout << left << setw(24) << res.name << setw(20) << res.strategy << setw(12) << res.avg_ns
+             << fixed << setprecision(2);
+        for (PerfEvent e : columns) {
+            if (res.perf.has(e)) cout << setw(12) << (double)res.perf.get(e) / res.ops;
+            else cout << setw(12) << "-";
+        }
+        if (res.perf.has(PerfEvent::Instructions) && res.perf.has(PerfEvent::Cycles) && res.perf.get(PerfEvent::Cycles))
+            cout << setw(12) << (double)res.perf.get(PerfEvent::Instructions) / res.perf.get(PerfEvent::Cycles);
+        else
+            cout << setw(12) << "-";
+        cout << defaultfloat << endl;
+    }
+    cout << string(140, '=') << endl;
+}
+
+// usage: benchmark_read [--keys N] [--timing-batch K] [--perf] [--index-file PATH]
+//                       [--zipf THETA] [--miss-ratio R] [--hot-fraction F] [--hot-access P] [--trace PATH]
+int main(int argc, char** argv)
 {
+    int N = 1000000;
+    string index_path = "/tmp/benchmark_read_index.bpt"; // saved static tree, removed at exit
+    workload::QuerySpec spec;  // skew / miss knobs of the workload strategy
+    spec.miss_ratio = 0.3;     // production: Zipf 0.99 with ~30% negative lookups
+    string trace_path;         // whitespace-separated int keys, replayed as one more workload
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--keys" && i + 1 < argc) {
+            N = stoi(argv[++i]);
+        } else if (arg == "--timing-batch" && i + 1 < argc) {
+            timing_batch = max(1, stoi(argv[++i]));
+        } else if (arg == "--index-file" && i + 1 < argc) {
+            index_path = argv[++i];
+        } else if (arg == "--zipf" && i + 1 < argc) {
+            spec.zipf_theta = stod(argv[++i]);
+        } else if (arg == "--miss-ratio" && i + 1 < argc) {
+            spec.miss_ratio = stod(argv[++i]);
+        } else if (arg == "--hot-fraction" && i + 1 < argc) {
+            spec.hot_fraction = stod(argv[++i]);
+        } else if (arg == "--hot-access" && i + 1 < argc) {
+            spec.hot_access = stod(argv[++i]);
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (arg == "--perf") {
+            perf_group.reset(new PerfCounterGroup());
+        } else {
+            cerr << "unknown argument " << arg << endl;
+            return 1;
+        }
+    }
+
     // Pre-warm the CPU
     pre_warm_cpu();
 
+    timer.calibrate();
+    cout << "Timer: " << setprecision(4) << (1.0 / timer.get_ns_per_tick()) << " ticks/ns, overhead "
+         << timer.get_overhead_ns() << " ns (subtracted), " << timing_batch << " op(s) per sample" << defaultfloat << endl;
+
+    if (perf_group) {
+        if (perf_group->available()) {
+            cout << "Hardware counters:";
+            for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                if (perf_group->has((PerfEvent)e)) cout << " " << perf_event_name((PerfEvent)e);
+            }
+            cout << endl;
+        } else {
+            cout << "Hardware counters unavailable (" << perf_group->get_error() << "), latencies only" << endl;
+            perf_group.reset();
+        }
+    }
+
     // initialize Arena allocator
     cout << "========================================" << endl;
     cout << "INITIALIZING ARENA ALLOCATOR" << endl;
     cout << "========================================" << endl;
-    global_arena = new Arena(ARENA_SIZE);
-    cout << "Arena capacity: " << (global_arena->get_capacity() / (1024.0 * 1024 * 1024)) << " GB" << endl;
+    // huge pages cut dTLB misses on the random descents
+    Arena arena(ARENA_INITIAL_SIZE, ARENA_MAX_SIZE, Arena::HugePages::Transparent);
+    cout << "Arena reserved: " << (arena.get_capacity() / (1024.0 * 1024)) << " MB (max "
+         << (arena.get_max_capacity() / (1024.0 * 1024 * 1024)) << " GB)" << endl;
+    cout << "Node search ISA: " << simd_isa_name(active_simd_isa()) << " (detected)" << endl;
     cout << "========================================\n" << endl;
 
-    const int N = 1000000;
     vector<BenchmarkResult> results;
 
     // Generate random keys
@@ -165,10 +480,58 @@ int main()
 
     // 1. B+ Tree
     cout << "  - Inserting into B+ Tree (Arena)..." << endl;
-    BPlusTree<int, int> tree;
+    BPlusTree<int, int> tree(arena);
+    auto build_start = chrono::steady_clock::now();
     for (int i = 0; i < N; i++) {
         tree.insert(random_keys[i], random_keys[i] * 10);
     }
+    auto build_end = chrono::steady_clock::now();
+
+    size_t tree_bytes = arena.get_used_memory(); // only the B+ Tree lives in the arena so far
+
+    // 1b. frozen snapshot of the same tree
+    cout << "  - Freezing B+ Tree into a static S+-tree..." << endl;
+    StaticBPlusTree<int, int> frozen = freeze(tree, Arena::HugePages::Transparent);
+    cout << "    B+ Tree: " << (tree_bytes / (1024.0 * 1024)) << " MB, static: "
+         << (frozen.memory_bytes() / (1024.0 * 1024)) << " MB (" << frozen.height() << " levels)" << endl;
+
+    // 1c. same snapshot with frame-of-reference leaves
+    CompressedStaticBPlusTree<int, int> compressed = freeze_compressed(tree, Arena::HugePages::Transparent);
+    cout << "    compressed: " << (compressed.memory_bytes() / (1024.0 * 1024)) << " MB, keys "
+         << ((double)compressed.key_bytes() / compressed.size()) << " B/key in " << compressed.block_count()
+         << " lines (1/2/4-byte deltas: " << compressed.blocks_with_width(1) << "/" << compressed.blocks_with_width(2)
+         << "/" << compressed.blocks_with_width(4) << ")" << endl;
+
+    // 1d. the snapshot on disk, mapped back: restart-to-serving without a rebuild
+    cout << "  - Saving static tree to " << index_path << " and mapping it back..." << endl;
+    auto save_start = chrono::steady_clock::now();
+    frozen.save(index_path);
+    auto open_start = chrono::steady_clock::now();
+    StaticBPlusTree<int, int> mapped = StaticBPlusTree<int, int>::open(index_path);
+    auto open_end = chrono::steady_clock::now();
+    int first_val = 0;
+    bool first_found = mapped.findSIMD(random_keys[0], first_val);
+    auto first_end = chrono::steady_clock::now();
+    cout << "    rebuild by insert: " << chrono::duration<double, milli>(build_end - build_start).count()
+         << " ms, save: " << chrono::duration<double, milli>(open_start - save_start).count()
+         << " ms, open: " << chrono::duration<double, milli>(open_end - open_start).count()
+         << " ms, first lookup: " << chrono::duration<double, micro>(first_end - open_end).count() << " us"
+         << (first_found ? "" : " (missing key!)") << endl;
+
+    // 1e. optimistic-lock-coupling tree (single threaded here: shows the cost of validation)
+    cout << "  - Inserting into Concurrent B+ Tree (OLC)..." << endl;
+    ConcurrentBPlusTree<int, int> olc_tree;
+    for (int i = 0; i < N; i++) {
+        olc_tree.insert(random_keys[i], random_keys[i] * 10);
+    }
+
+    // 1f. same keys behind a Bloom filter (misses skip the descent)
+    cout << "  - Inserting into B+ Tree (Bloom filter)..." << endl;
+    BloomTree bloom_tree(arena);
+    for (int i = 0; i < N; i++) {
+        bloom_tree.insert(random_keys[i], random_keys[i] * 10);
+    }
+    cout << "    filter: " << (bloom_tree.stats().filter_bytes / (1024.0 * 1024)) << " MB" << endl;
 
     // 2. std::map
     cout << "  - Inserting into std::map..." << endl;
@@ -196,6 +559,70 @@ int main()
         return tree.findSIMD(key, val);
     }));
 
+    results.push_back(run_benchmark("Static S+Tree", "Random Read", N, query_keys, [&](int key) {
+        int val;
+        return frozen.findSIMD(key, val);
+    }));
+
+    results.push_back(run_benchmark("Compressed S+Tree", "Random Read", N, query_keys, [&](int key) {
+        int val;
+        return compressed.findSIMD(key, val);
+    }));
+    results.push_back(run_benchmark("Static (mmap file)", "Random Read", N, query_keys, [&](int key) {
+        int val;
+        return mapped.findSIMD(key, val);
+    }));
+
+    results.push_back(run_benchmark("Concurrent (OLC)", "Random Read", N, query_keys, [&](int key) {
+        int val;
+        return olc_tree.findSIMD(key, val);
+    }));
+
+    // popcount over the padded nodes, no exits on the key data (compare P99 / P99.9 with SIMD)
+    results.push_back(run_benchmark("B+ Tree (Branchless)", "Random Read", N, query_keys, [&](int key) {
+        int val;
+        return tree.findBranchless(key, val);
+    }));
+
+    // same lookups with each node search variant this CPU can run forced in turn
+    const SimdIsa detected_isa = active_simd_isa();
+    for (SimdIsa isa : {SimdIsa::Scalar, SimdIsa::SSE42, SimdIsa::AVX2, SimdIsa::AVX512, SimdIsa::NEON}) {
+        if (!set_simd_isa(isa)) continue;
+        results.push_back(run_benchmark("B+ Tree (" + string(simd_isa_name(isa)) + ")", "Random Read", N, query_keys, [&](int key) {
+            int val;
+            return tree.findSIMD(key, val);
+        }));
+    }
+    set_simd_isa(detected_isa);
+
+    // B+ Tree, batched descents (per-key amortized latency)
+    vector<int> batch_out(128);
+    vector<uint8_t> batch_found(128);
+    for (size_t batch : {1, 8, 32, 128}) {
+        results.push_back(run_batch_benchmark("B+ Tree (Batch " + to_string(batch) + ")", "Random Read", N, query_keys, batch,
+            [&](const int* keys, size_t n) {
+                tree.findBatch(keys, n, batch_out.data(), batch_found.data());
+                size_t hits = 0;
+                for (size_t j = 0; j < n; j++) hits += batch_found[j];
+                return hits;
+            }));
+    }
+
+#if BPT_HAS_COROUTINES
+    // B+ Tree, coroutine lookups: up to `width` descents in flight, refilled as each one finishes
+    // (build with -std=c++20 for these rows)
+    for (size_t width : {4, 8, 16, 32}) {
+        async_lookup::RoundRobinScheduler scheduler(width);
+        results.push_back(run_batch_benchmark("B+ Tree (Coro " + to_string(width) + ")", "Random Read", N, query_keys, 128,
+            [&](const int* keys, size_t n) {
+                async_lookup::find_interleaved(tree, keys, n, batch_out.data(), batch_found.data(), scheduler);
+                size_t hits = 0;
+                for (size_t j = 0; j < n; j++) hits += batch_found[j];
+                return hits;
+            }));
+    }
+#endif
+
     // std::map
     results.push_back(run_benchmark("std::map", "Random Read", N, query_keys, [&](int key) {
         auto it = stl_map.find(key);
@@ -218,6 +645,14 @@ int main()
         int val;
         return tree.findSIMD(key, val);
     }));
+    results.push_back(run_benchmark("B+ Tree (Branchless)", "Sequential Read", N, query_keys, [&](int key) {
+        int val;
+        return tree.findBranchless(key, val);
+    }));
+    results.push_back(run_benchmark("Static S+Tree", "Sequential Read", N, query_keys, [&](int key) {
+        int val;
+        return frozen.findSIMD(key, val);
+    }));
 
     // std::map
     results.push_back(run_benchmark("std::map", "Sequential Read", N, query_keys, [&](int key) {
@@ -231,12 +666,146 @@ int main()
         return it != stl_unordered_map.end();
     }));
 
+    // --- STRATEGY 3: RANGE SCAN ---
+    // keys are ~1 per 10 in [1, N*10], so a span of 1000 walks ~100 entries
+    cout << "Running Range Scan Benchmark..." << endl;
+    const int SCAN_SPAN = 1000;
+    shuffle(query_keys.begin(), query_keys.end(), gen);
+    volatile long long scan_sink = 0;
+
+    // B+ Tree (one descent, then walk the leaf chain)
+    results.push_back(run_benchmark("B+ Tree (Leaves)", "Range Scan", N, query_keys, [&](int key) {
+        long long sum = 0;
+        size_t n = tree.scan(key, key + SCAN_SPAN, [&](int, int v) { sum += v; });
+        scan_sink = scan_sink + sum;
+        return n != 0;
+    }));
+
+    // B+ Tree (iterator API)
+    results.push_back(run_benchmark("B+ Tree (Iterator)", "Range Scan", N, query_keys, [&](int key) {
+        long long sum = 0;
+        size_t n = 0;
+        for (auto kv : tree.range(key, key + SCAN_SPAN)) {
+            sum += kv.second;
+            n++;
+        }
+        scan_sink = scan_sink + sum;
+        return n != 0;
+    }));
+
+    // std::map
+    results.push_back(run_benchmark("std::map", "Range Scan", N, query_keys, [&](int key) {
+        long long sum = 0;
+        size_t n = 0;
+        for (auto it = stl_map.lower_bound(key); it != stl_map.end() && it->first < key + SCAN_SPAN; ++it) {
+            sum += it->second;
+            n++;
+        }
+        scan_sink = scan_sink + sum;
+        return n != 0;
+    }));
+
+    // --- STRATEGY 4: KEY WIDTHS (SIMD vs BINARY) ---
+    cout << "Running Key Width Benchmark..." << endl;
+    run_key_width_benchmark<int32_t>("int32", arena, N, random_keys, query_keys,
+        [](int k) { return (int32_t)k; }, results);
+    // offset past 2^31 so the sign-flip path actually sees high-bit keys
+    run_key_width_benchmark<uint32_t>("uint32", arena, N, random_keys, query_keys,
+        [](int k) { return (uint32_t)k + 0x80000000u; }, results);
+    // nanosecond-timestamp-like values
+    run_key_width_benchmark<int64_t>("int64", arena, N, random_keys, query_keys,
+        [](int k) { return (int64_t)k * 1000000000LL; }, results);
+    run_key_width_benchmark<uint64_t>("uint64", arena, N, random_keys, query_keys,
+        [](int k) { return (uint64_t)k << 40; }, results);
+    run_key_width_benchmark<float>("float", arena, N, random_keys, query_keys,
+        [](int k) { return (float)k; }, results);
+    run_key_width_benchmark<double>("double", arena, N, random_keys, query_keys,
+        [](int k) { return (double)k * 0.001; }, results);
+
+    // --- STRATEGY 5: NODE LAYOUT ---
+    // sorted keys[] vs 16-key summary line + 16-key data lines, across fanouts
+    cout << "Running Node Layout Benchmark..." << endl;
+    run_layout_benchmark<64, SortedLayout>("Sorted", arena, N, random_keys, query_keys, results);
+    run_layout_benchmark<64, BlockedLayout>("Blocked", arena, N, random_keys, query_keys, results);
+    run_layout_benchmark<256, SortedLayout>("Sorted", arena, N, random_keys, query_keys, results);
+    run_layout_benchmark<256, BlockedLayout>("Blocked", arena, N, random_keys, query_keys, results);
+    run_layout_benchmark<1024, SortedLayout>("Sorted", arena, N, random_keys, query_keys, results);
+    run_layout_benchmark<1024, BlockedLayout>("Blocked", arena, N, random_keys, query_keys, results);
+
+    // --- STRATEGY 6: STRING KEYS ---
+    cout << "Running String Key Benchmark..." << endl;
+    run_string_key_benchmark(arena, N, random_keys, query_keys, results);
+
+    // --- STRATEGY 7: SCANS + POINT LOOKUPS ---
+    // a ~200k-entry scan every 1024 lookups, with and without the top-levels mirror
+    cout << "Running Scan + Point Benchmark..." << endl;
+    shuffle(query_keys.begin(), query_keys.end(), gen);
+    const int MIX_SCAN_EVERY = 1024;
+    const int MIX_SCAN_SPAN = 2000000;
+    results.push_back(run_scan_mix_benchmark("B+ Tree (SIMD)", tree, N, query_keys, MIX_SCAN_EVERY, MIX_SCAN_SPAN));
+    tree.enable_top_cache();
+    cout << "  - top-levels cache: " << tree.top_cache_levels() << " level(s), " << tree.top_cache_bytes() << " bytes" << endl;
+    results.push_back(run_scan_mix_benchmark("B+ Tree (Top cache)", tree, N, query_keys, MIX_SCAN_EVERY, MIX_SCAN_SPAN));
+    results.push_back(run_benchmark("B+ Tree (Top cache)", "Random Read", N, query_keys, [&](int key) {
+        int val;
+        return tree.findSIMD(key, val);
+    }));
+    tree.disable_top_cache();
+
+    // --- STRATEGY 8: WORKLOADS ---
+    // the same containers under skewed popularity and negative lookups; population is the distinct
+    // inserted keys in random popularity order, misses come from the gaps of [1, N*10]
+    cout << "Running Workload Benchmark..." << endl;
+    vector<int> population = random_keys;
+    sort(population.begin(), population.end());
+    population.erase(unique(population.begin(), population.end()), population.end());
+    shuffle(population.begin(), population.end(), gen);
+
+    auto skew_label = [](const char* dist, double theta) {
+        ostringstream label;
+        label << dist << " " << theta;
+        return label.str();
+    };
+    auto miss_label = [&](string label) {
+        return spec.miss_ratio > 0 ? label + " +" + to_string((int)lround(spec.miss_ratio * 100)) + "% miss" : label;
+    };
+    workload::QuerySpec uniform_miss = spec;
+    uniform_miss.dist = workload::Distribution::Uniform;
+    workload::QuerySpec zipf_hits = spec;
+    zipf_hits.dist = workload::Distribution::Zipf;
+    zipf_hits.miss_ratio = 0;
+    workload::QuerySpec zipf_miss = spec;
+    zipf_miss.dist = workload::Distribution::Zipf;
+    workload::QuerySpec hot_set = spec;
+    hot_set.dist = workload::Distribution::HotSet;
+    hot_set.miss_ratio = 0;
+
+    if (spec.miss_ratio > 0) {
+        run_workload_benchmark(miss_label("Uniform"), workload::make_queries(population, N, uniform_miss, 1, N * 10, gen),
+                               tree, bloom_tree, frozen, stl_map, stl_unordered_map, results);
+    }
+    run_workload_benchmark(skew_label("Zipf", spec.zipf_theta), workload::make_queries(population, N, zipf_hits, 1, N * 10, gen),
+                           tree, bloom_tree, frozen, stl_map, stl_unordered_map, results);
+    if (spec.miss_ratio > 0) {
+        run_workload_benchmark(miss_label(skew_label("Zipf", spec.zipf_theta)),
+                               workload::make_queries(population, N, zipf_miss, 1, N * 10, gen),
+                               tree, bloom_tree, frozen, stl_map, stl_unordered_map, results);
+    }
+    run_workload_benchmark("Hot " + to_string((int)lround(spec.hot_fraction * 100)) + "/" +
+                               to_string((int)lround(spec.hot_access * 100)),
+                           workload::make_queries(population, N, hot_set, 1, N * 10, gen),
+                           tree, bloom_tree, frozen, stl_map, stl_unordered_map, results);
+    if (!trace_path.empty()) {
+        vector<int> trace = workload::load_trace<int>(trace_path);
+        cout << "  - Replaying " << trace.size() << " keys from " << trace_path << endl;
+        run_workload_benchmark("Trace", trace, tree, bloom_tree, frozen, stl_map, stl_unordered_map, results);
+    }
+    run_append_benchmark(arena, N, spec, gen, results);
+
     // --- PRINT RESULTS ---
     print_table(results);
-
-    // Cleanup arena
-    delete global_arena;
-    global_arena = nullptr;
+    std::remove(index_path.c_str());
+    if (perf_group) print_perf_table(results);
 
     return 0;
 }
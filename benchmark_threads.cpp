@@ -0,0 +1,436 @@
+#include "bplustree.hpp"
+#include "concurrent_bplustree.hpp"
+#include "cow_bplustree.hpp"
+#include "sharded_bplustree.hpp"
+#include "bench_timer.hpp"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <map>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <iomanip>
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+
+using namespace std;
+
+// usage: benchmark_threads [--threads 1,2,4,8] [--keys N] [--ops N] [--workloads A,B,C,E]
+//                          [--mix read,update,insert,delete,scan] [--csv out.csv] [--no-pin]
+// --ops is the total across all threads, so every thread count does the same amount of work
+
+const size_t ARENA_INITIAL_SIZE = 64ULL * 1024 * 1024;  // 64 MB, grows in chunks from here
+const size_t ARENA_MAX_SIZE = 4ULL * 1024 * 1024 * 1024; // 4 GB
+const int SCAN_SPAN = 100; // keys are dense, so a scan visits ~100 entries
+
+// operation percentages, must add up to 100
+struct Mix {
+    string name;
+    int read;
+    int update;
+    int insert;
+    int remove;
+    int scan;
+};
+
+// YCSB core workloads (D / F left out: latest-distribution reads, read-modify-write)
+const vector<Mix> YCSB_MIXES = {
+    {"A", 50, 50, 0, 0, 0},  // update heavy
+    {"B", 95, 5, 0, 0, 0},   // read mostly
+    {"C", 100, 0, 0, 0, 0},  // read only
+    {"E", 0, 0, 5, 0, 95},   // short ranges
+};
+
+struct ThreadResult {
+    string workload;
+    string container;
+    int threads;
+    double mops;
+    long long avg_ns;
+    long long p50_ns;
+    long long p90_ns;
+    long long p99_ns;
+    long long p999_ns;
+    long long max_ns;
+};
+
+// --- CONTAINERS ---
+// one adapter per container, all keys / values are int
+
+// the single-threaded tree behind a reader-writer lock (what callers do today)
+struct LockedBPlusTree {
+    static constexpr bool supports_scan = true;
+    static string name() { return "B+ Tree (rwlock)"; }
+
+    Arena arena{ARENA_INITIAL_SIZE, ARENA_MAX_SIZE, Arena::HugePages::Transparent};
+    BPlusTree<int, int> tree{arena};
+    mutable shared_mutex lock;
+
+    bool read(int key) {
+        shared_lock<shared_mutex> guard(lock);
+        int val;
+        return tree.findSIMD(key, val);
+    }
+    void write(int key, int value) {
+        unique_lock<shared_mutex> guard(lock);
+        tree.insert(key, value);
+    }
+    void remove(int key) {
+        unique_lock<shared_mutex> guard(lock);
+        tree.remove(key);
+    }
+    size_t scan(int key) {
+        shared_lock<shared_mutex> guard(lock);
+        return tree.scan(key, key + SCAN_SPAN, [](const int&, const int&) {});
+    }
+};
+
+// key range cut over one tree per shard (rwlock each, arenas spread over the NUMA nodes): the
+// harness draws keys uniformly, so this shows the lock split, not socket-local routing
+struct ShardedTree {
+    static constexpr bool supports_scan = true;
+    static constexpr int SHARDS = 16;
+    static string name() { return "B+ Tree (16 shards)"; }
+
+    static int key_space;
+    ShardedBPlusTree<int, int> tree{ShardedBPlusTree<int, int>::split_evenly(0, key_space, SHARDS), {},
+                                    Arena::HugePages::Transparent, ARENA_INITIAL_SIZE / SHARDS};
+
+    bool read(int key) {
+        int val;
+        return tree.findSIMD(key, val);
+    }
+    void write(int key, int value) { tree.insert(key, value); }
+    void remove(int key) { tree.remove(key); }
+    size_t scan(int key) { return tree.scan(key, key + SCAN_SPAN, [](const int&, const int&) {}); }
+};
+int ShardedTree::key_space = 2000000; // preloaded keys span [0, 2 * num_keys), set in main
+
+// optimistic lock coupling, readers never block
+struct OlcBPlusTree {
+    static constexpr bool supports_scan = false;
+    static string name() { return "B+ Tree (OLC)"; }
+
+    ConcurrentBPlusTree<int, int> tree;
+
+    bool read(int key) {
+        int val;
+        return tree.findSIMD(key, val);
+    }
+    void write(int key, int value) { tree.insert(key, value); }
+    void remove(int key) { tree.remove(key); }
+    size_t scan(int) { return 0; }
+};
+
+// path copying: readers load the root once and never synchronize, every write copies a path
+// (meant for read-mostly mixes like B / C, update-heavy A shows the copy cost)
+struct CowTree {
+    static constexpr bool supports_scan = true;
+    static string name() { return "B+ Tree (COW)"; }
+
+    CowBPlusTree<int, int> tree;
+
+    bool read(int key) {
+        int val;
+        return tree.findSIMD(key, val);
+    }
+    void write(int key, int value) { tree.insert(key, value); }
+    void remove(int key) { tree.remove(key); }
+    size_t scan(int key) { return tree.snapshot().scan(key, key + SCAN_SPAN, [](const int&, const int&) {}); }
+};
+
+struct LockedMap {
+    static constexpr bool supports_scan = true;
+    static string name() { return "std::map"; }
+
+    map<int, int> m;
+    mutable shared_mutex lock;
+
+    bool read(int key) {
+        shared_lock<shared_mutex> guard(lock);
+        return m.find(key) != m.end();
+    }
+    void write(int key, int value) {
+        unique_lock<shared_mutex> guard(lock);
+        m[key] = value;
+    }
+    void remove(int key) {
+        unique_lock<shared_mutex> guard(lock);
+        m.erase(key);
+    }
+    size_t scan(int key) {
+        shared_lock<shared_mutex> guard(lock);
+        size_t count = 0;
+        for (auto it = m.lower_bound(key); it != m.end() && it->first < key + SCAN_SPAN; ++it) count++;
+        return count;
+    }
+};
+
+struct LockedUnorderedMap {
+    static constexpr bool supports_scan = false;
+    static string name() { return "std::unordered_map"; }
+
+    unordered_map<int, int> m;
+    mutable shared_mutex lock;
+
+    bool read(int key) {
+        shared_lock<shared_mutex> guard(lock);
+        return m.find(key) != m.end();
+    }
+    void write(int key, int value) {
+        unique_lock<shared_mutex> guard(lock);
+        m[key] = value;
+    }
+    void remove(int key) {
+        unique_lock<shared_mutex> guard(lock);
+        m.erase(key);
+    }
+    size_t scan(int) { return 0; }
+};
+
+// --- HARNESS ---
+// calibrated once in main, shared by every worker
+CycleTimer timer;
+
+void pin_to_cpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % max(1u, thread::hardware_concurrency()), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+template<typename Container>
+ThreadResult run_mix(const Mix& mix, int threads, int num_keys, long long total_ops, bool pin) {
+    Container container;
+    // preload: even keys 0..2N, odd keys are left for inserts / delete misses
+    for (int i = 0; i < num_keys; i++) {
+        container.write(i * 2, i);
+    }
+
+    long long ops_per_thread = total_ops / threads;
+    vector<LatencyHistogram> histograms(threads);
+    vector<long long> sinks(threads); // per-thread read results, summed after join()
+    atomic<int> ready{0};
+    atomic<bool> go{false};
+
+    auto worker = [&](int tid) {
+        if (pin) pin_to_cpu(tid);
+        mt19937 gen(1234 + tid);
+        uniform_int_distribution<int> key_dist(0, num_keys * 2 - 1);
+        uniform_int_distribution<int> op_dist(0, 99);
+        LatencyHistogram hist; // thread-local while running, no false sharing on the counters
+        long long local_sink = 0;
+        // fresh keys for inserts, disjoint per thread
+        int next_insert = num_keys * 2 + tid;
+
+        ready++;
+        while (!go.load(memory_order_acquire)) {}
+
+        for (long long i = 0; i < ops_per_thread; i++) {
+            int op = op_dist(gen);
+            int key = key_dist(gen);
+            uint64_t start = CycleTimer::start();
+            if ((op -= mix.read) < 0) {
+                local_sink += container.read(key);
+            } else if ((op -= mix.update) < 0) {
+                container.write(key & ~1, key);
+            } else if ((op -= mix.insert) < 0) {
+                container.write(next_insert, next_insert);
+                next_insert += threads;
+            } else if ((op -= mix.remove) < 0) {
+                container.remove(key);
+            } else {
+                local_sink += container.scan(key);
+            }
+            uint64_t end = CycleTimer::stop();
+            hist.record((uint64_t)timer.to_ns(start, end));
+        }
+        sinks[tid] = local_sink;
+        histograms[tid] = move(hist);
+    };
+
+    vector<thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(worker, t);
+    while (ready.load() < threads) {}
+
+    auto wall_start = chrono::high_resolution_clock::now();
+    go.store(true, memory_order_release);
+    for (auto& th : pool) th.join();
+    auto wall_end = chrono::high_resolution_clock::now();
+
+    // keep the reads observable so they can't be optimized away
+    long long sink_total = 0;
+    for (long long s : sinks) sink_total += s;
+    volatile long long keep_alive = sink_total;
+    (void)keep_alive;
+
+    // merge every thread's histogram so the percentiles cover the whole run
+    LatencyHistogram merged;
+    for (auto& hist : histograms) merged.merge(hist);
+
+    double wall_ns = chrono::duration<double, nano>(wall_end - wall_start).count();
+    return {
+        mix.name,
+        Container::name(),
+        threads,
+        merged.count() * 1000.0 / wall_ns,
+        (long long)merged.mean(),
+        (long long)merged.percentile(0.50),
+        (long long)merged.percentile(0.90),
+        (long long)merged.percentile(0.99),
+        (long long)merged.percentile(0.999),
+        (long long)merged.max()
+    };
+}
+
+void print_table(const vector<ThreadResult>& results) {
+    cout << "\n" << string(132, '=') << endl;
+    cout << left << setw(10) << "Workload"
+         << setw(24) << "Container"
+         << setw(10) << "Threads"
+         << setw(12) << "Mops/s"
+         << setw(12) << "Avg(ns)"
+         << setw(12) << "P50(ns)"
+         << setw(12) << "P90(ns)"
+         << setw(12) << "P99(ns)"
+         << setw(12) << "P99.9(ns)"
+         << setw(12) << "Max(ns)" << endl;
+    cout << string(132, '-') << endl;
+    for (const auto& res : results) {
+        cout << left << setw(10) << res.workload
+             << setw(24) << res.container
+             << setw(10) << res.threads
+             << fixed << setprecision(2) << setw(12) << res.mops << defaultfloat
+             << setw(12) << res.avg_ns
+             << setw(12) << res.p50_ns
+             << setw(12) << res.p90_ns
+             << setw(12) << res.p99_ns
+             << setw(12) << res.p999_ns
+             << setw(12) << res.max_ns << endl;
+    }
+    cout << string(132, '=') << endl;
+}
+
+void write_csv(const string& path, const vector<ThreadResult>& results) {
+    ofstream out(path);
+    out << "workload,container,threads,mops,avg_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n";
+    for (const auto& res : results) {
+        out << res.workload << ',' << res.container << ',' << res.threads << ',' << res.mops << ','
+            << res.avg_ns << ',' << res.p50_ns << ',' << res.p90_ns << ',' << res.p99_ns << ','
+            << res.p999_ns << ',' << res.max_ns << '\n';
+    }
+}
+
+vector<string> split_list(const string& arg) {
+    vector<string> items;
+    stringstream ss(arg);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+template<typename Container>
+void run_container(const Mix& mix, const vector<int>& thread_counts, int num_keys, long long total_ops,
+                   bool pin, vector<ThreadResult>& results) {
+    if (mix.scan > 0 && !Container::supports_scan) return;
+    for (int threads : thread_counts) {
+        cout << "  " << mix.name << " / " << Container::name() << " / " << threads << " threads..." << endl;
+        results.push_back(run_mix<Container>(mix, threads, num_keys, total_ops, pin));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    vector<int> thread_counts;
+    for (unsigned t = 1; t <= max(1u, thread::hardware_concurrency()); t *= 2) thread_counts.push_back(t);
+    int num_keys = 1000000;
+    long long total_ops = 2000000;
+    vector<Mix> mixes = YCSB_MIXES;
+    string csv_path;
+    bool pin = true;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        string next = i + 1 < argc ? argv[i + 1] : "";
+        if (arg == "--threads") {
+            thread_counts.clear();
+            for (auto& t : split_list(next)) thread_counts.push_back(stoi(t));
+            i++;
+        } else if (arg == "--keys") {
+            num_keys = stoi(next);
+            i++;
+        } else if (arg == "--ops") {
+            total_ops = stoll(next);
+            i++;
+        } else if (arg == "--workloads") {
+            mixes.clear();
+            for (auto& name : split_list(next)) {
+                for (auto& mix : YCSB_MIXES) {
+                    if (mix.name == name) mixes.push_back(mix);
+                }
+            }
+            i++;
+        } else if (arg == "--mix") {
+            auto parts = split_list(next);
+            if (parts.size() != 5) {
+                cerr << "--mix needs read,update,insert,delete,scan percentages" << endl;
+                return 1;
+            }
+            mixes = {{"custom", stoi(parts[0]), stoi(parts[1]), stoi(parts[2]), stoi(parts[3]), stoi(parts[4])}};
+            i++;
+        } else if (arg == "--csv") {
+            csv_path = next;
+            i++;
+        } else if (arg == "--no-pin") {
+            pin = false;
+        } else {
+            cerr << "unknown argument " << arg << endl;
+            return 1;
+        }
+    }
+
+    for (auto& mix : mixes) {
+        if (mix.read + mix.update + mix.insert + mix.remove + mix.scan != 100) {
+            cerr << "mix " << mix.name << " does not add up to 100%" << endl;
+            return 1;
+        }
+    }
+
+    cout << "========================================" << endl;
+    cout << "MULTI-THREADED BENCHMARK" << endl;
+    cout << "Keys: " << num_keys << ", ops per run: " << total_ops
+         << ", pinning: " << (pin ? "on" : "off") << endl;
+    cout << "Node search ISA: " << simd_isa_name(active_simd_isa()) << endl;
+    cout << "========================================\n" << endl;
+
+    timer.calibrate();
+    ShardedTree::key_space = num_keys * 2;
+
+    vector<ThreadResult> results;
+    for (auto& mix : mixes) {
+        run_container<LockedBPlusTree>(mix, thread_counts, num_keys, total_ops, pin, results);
+        run_container<ShardedTree>(mix, thread_counts, num_keys, total_ops, pin, results);
+        run_container<OlcBPlusTree>(mix, thread_counts, num_keys, total_ops, pin, results);
+        run_container<CowTree>(mix, thread_counts, num_keys, total_ops, pin, results);
+        run_container<LockedMap>(mix, thread_counts, num_keys, total_ops, pin, results);
+        run_container<LockedUnorderedMap>(mix, thread_counts, num_keys, total_ops, pin, results);
+    }
+
+    print_table(results);
+    if (!csv_path.empty()) {
+        write_csv(csv_path, results);
+        cout << "CSV written to " << csv_path << endl;
+    }
+    return 0;
+}
@@ -2,273 +2,1970 @@
 
 #include <iostream>
 #include <algorithm>
-#include <immintrin.h>
 #include <stdexcept>
 #include <cstring>
 #include <cstdint>
+#include <cstddef>
+#include <iterator>
 #include <type_traits>
+#include <utility>
+#include <vector>
+#include <new>
+#include <memory>
+#include <sys/mman.h>
+
+#include "key_filter.hpp"
+#include "node_layout.hpp"
+#include "node_search.hpp"
+#include "numa.hpp"
 
 // --- ARENA ---
+// bump allocator over a chain of mmap'd chunks. starts with initial_size reserved and
+// grows by doubling chunks until max_size, pages are only faulted in when first touched.
+// numa_node >= 0 mbinds every chunk to that node before its first byte is written
 class Arena
 {
+public:
+    enum class HugePages
+    {
+        Off,         // regular 4 KB pages
+        Transparent, // 2 MB aligned chunks + MADV_HUGEPAGE, kernel promotes them when it can
+        Explicit     // MAP_HUGETLB from the reserved hugetlbfs pool, falls back to Transparent
+    };
+
+    static constexpr size_t DEFAULT_INITIAL_SIZE = 64ULL * 1024 * 1024; // 64 MB
+    static constexpr size_t UNLIMITED = SIZE_MAX;
+
 private:
-    char *memory;
-    size_t offset;
-    size_t capacity;
+    static constexpr size_t HUGE_PAGE_SIZE = 2ULL * 1024 * 1024;
+    static constexpr size_t MAX_CHUNK_GROWTH = 1ULL * 1024 * 1024 * 1024; // stop doubling at 1 GB chunks
+    static constexpr size_t CHUNK_HEADER = 64; // keeps the first allocation cache line aligned
 
-public:
-    Arena(size_t size) : offset(0), capacity(size)
+    // lives at the start of its own mapping
+    struct Chunk
+    {
+        Chunk *prev;        // previously filled chunk
+        size_t mapped_size; // what to munmap
+    };
+
+    Chunk *current;
+    char *cursor; // next free byte in current chunk
+    char *limit;  // end of current chunk
+    size_t used;     // bytes handed out in earlier chunks
+    size_t capacity; // bytes reserved across all chunks
+    size_t initial_size;
+    size_t max_size;
+    size_t next_chunk_size;
+    HugePages huge_pages;
+    int numa_node;   // -1 = wherever the first touch lands
+    bool numa_bound; // every chunk so far was mbind'ed to numa_node
+
+    static void *map_chunk(size_t size, HugePages mode)
+    {
+#ifdef MAP_HUGETLB
+        if (mode == HugePages::Explicit)
+        {
+            void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (mem != MAP_FAILED)
+            {
+                return mem;
+            }
+            // no pool configured, fall through to THP
+            mode = HugePages::Transparent;
+        }
+#endif
+        if (mode == HugePages::Off)
+        {
+            void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            return mem == MAP_FAILED ? nullptr : mem;
+        }
+
+        // over-map by one huge page and trim, so the chunk starts on a 2 MB boundary
+        size_t padded = size + HUGE_PAGE_SIZE;
+        void *raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        uintptr_t start = ((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+        size_t head = start - (uintptr_t)raw;
+        if (head)
+        {
+            munmap(raw, head);
+        }
+        size_t tail = padded - head - size;
+        if (tail)
+        {
+            munmap((char *)start + size, tail);
+        }
+#ifdef MADV_HUGEPAGE
+        madvise((void *)start, size, MADV_HUGEPAGE);
+#endif
+        return (void *)start;
+    }
+
+    size_t round_chunk(size_t size) const
+    {
+        size_t granule = huge_pages == HugePages::Off ? 4096 : HUGE_PAGE_SIZE;
+        return (size + granule - 1) & ~(granule - 1);
+    }
+
+    // slow path: current chunk can't fit `bytes`, chain a new one
+    void grow(size_t bytes)
     {
-        memory = (char *)malloc(size);
-        if (!memory)
+        size_t want = round_chunk(std::max(next_chunk_size, bytes + CHUNK_HEADER));
+        if (capacity + want > max_size)
+        {
+            // last chunk may be smaller than the doubling schedule, but it has to fit the request
+            want = (max_size - capacity) & ~(size_t)4095;
+            if (want < bytes + CHUNK_HEADER)
+            {
+                throw std::runtime_error("Arena out of memory");
+            }
+        }
+
+        void *mem = map_chunk(want, huge_pages);
+        if (!mem)
         {
             throw std::runtime_error("Failed to allocate arena memory");
         }
-        std::cout << "Arena initialized with " << (size / (1024.0 * 1024 * 1024)) << " GB" << std::endl;
+        if (numa_node >= 0)
+        {
+            // before the chunk header below touches the first page
+            numa_bound = numa::bind_memory(mem, want, numa_node) && (numa_bound || !current);
+        }
+
+        if (current)
+        {
+            used += cursor - ((char *)current + CHUNK_HEADER);
+        }
+
+        Chunk *chunk = (Chunk *)mem;
+        chunk->prev = current;
+        chunk->mapped_size = want;
+        current = chunk;
+        cursor = (char *)mem + CHUNK_HEADER;
+        limit = (char *)mem + want;
+        capacity += want;
+        next_chunk_size = std::min(want * 2, MAX_CHUNK_GROWTH);
+    }
+
+    void release_chunks(Chunk *chunk)
+    {
+        while (chunk)
+        {
+            Chunk *prev = chunk->prev;
+            munmap(chunk, chunk->mapped_size);
+            chunk = prev;
+        }
+    }
+
+public:
+    explicit Arena(size_t initial = DEFAULT_INITIAL_SIZE, size_t max = UNLIMITED, HugePages huge = HugePages::Off,
+                   int numa_node = -1)
+        : current(nullptr), cursor(nullptr), limit(nullptr), used(0), capacity(0),
+          initial_size(initial), max_size(max), next_chunk_size(initial), huge_pages(huge),
+          numa_node(numa_node), numa_bound(false)
+    {
+        if (initial > max)
+        {
+            throw std::invalid_argument("Arena initial size exceeds max size");
+        }
+        grow(0);
     }
 
     ~Arena()
     {
-        free(memory);
+        release_chunks(current);
     }
 
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
     void *allocate(size_t bytes)
     {
         // 64 bytes for cache line alignment (AVX friendly)
         size_t aligned_bytes = (bytes + 63) & ~63;
         
-        if (offset + aligned_bytes > capacity)
+        if (__builtin_expect((size_t)(limit - cursor) < aligned_bytes, 0))
+        {
+            grow(aligned_bytes);
+        }
+
+        void *ptr = cursor;
+        cursor += aligned_bytes;
+        return ptr;
+    }
+
+    // bytes handed out so far (tail of a filled chunk that was skipped is not counted)
+    size_t get_used_memory() const
+    {
+        return used + (cursor - ((char *)current + CHUNK_HEADER));
+    }
+
+    // bytes currently reserved from the OS
+    size_t get_capacity() const
+    {
+        return capacity;
+    }
+
+    size_t get_max_capacity() const
+    {
+        return max_size;
+    }
+
+    size_t get_chunk_count() const
+    {
+        size_t n = 0;
+        for (Chunk *c = current; c; c = c->prev)
+        {
+            n++;
+        }
+        return n;
+    }
+
+    HugePages get_huge_pages() const
+    {
+        return huge_pages;
+    }
+
+    int get_numa_node() const
+    {
+        return numa_node;
+    }
+
+    // false if any chunk could not be bound (no NUMA support): its pages are placed by first touch
+    bool is_numa_bound() const
+    {
+        return numa_bound;
+    }
+
+    // drops everything and goes back to a single chunk of initial_size
+    void reset()
+    {
+        release_chunks(current);
+        current = nullptr;
+        used = 0;
+        capacity = 0;
+        next_chunk_size = initial_size;
+        grow(0);
+    }
+};
+
+// --- OPERATION COUNTERS ---
+// what the tree did, summed over its lifetime. Only counted when compiled with -DBPT_STATS
+// (a few adds on the hot paths), otherwise the fields stay zero and the counting compiles away
+struct BPlusTreeCounters
+{
+    uint64_t lookups = 0;      // find* calls, one per key for findBatch
+    uint64_t lookup_nodes = 0; // nodes visited by lookups, leaf included
+    uint64_t inserts = 0;
+    uint64_t insert_nodes = 0; // nodes visited by inserts, leaf included
+    uint64_t leaf_splits = 0;
+    uint64_t inner_splits = 0;
+    uint64_t keys_shifted = 0; // keys moved by inserts to open a slot or fill a new sibling
+    uint64_t filter_rejects = 0; // lookups the key filter answered without a descent (part of lookups)
+    uint64_t top_cache_rebuilds = 0; // whole rebuilds of the top-levels cache (patches not counted)
+};
+
+// --- TREE STATISTICS ---
+// snapshot returned by BPlusTree::stats(). Fill is num_keys over what a node holds at rest
+// (M - 1 keys, a node reaching M splits)
+struct BPlusTreeStats
+{
+    static constexpr int FILL_BUCKETS = 10; // bucket b = fill in [b * 10%, (b + 1) * 10%), 100% in the last
+
+    size_t keys = 0;
+    int height = 0;                      // levels, a lone leaf is 1
+    std::vector<size_t> nodes_per_level; // [0] = root level, back() = leaves
+    size_t leaf_nodes = 0;
+    size_t internal_nodes = 0;
+    size_t leaf_fill[FILL_BUCKETS] = {};
+    size_t internal_fill[FILL_BUCKETS] = {};
+    double leaf_fill_factor = 0;     // average over all leaves
+    double internal_fill_factor = 0; // average over all internal nodes, 0 without any
+
+    size_t total_bytes = 0;     // live nodes + nodes parked on the free lists
+    size_t payload_bytes = 0;   // keys * (sizeof key + sizeof value)
+    size_t wasted_bytes = 0;    // empty key / value / child slots of live nodes + free-listed nodes
+    size_t free_list_bytes = 0; // part of total_bytes kept for reuse
+    size_t filter_bytes = 0;    // key filter, part of total_bytes (0 without one)
+    size_t top_cache_bytes = 0; // top-levels cache, part of total_bytes (0 when off)
+    double bytes_per_key = 0;   // total_bytes / keys
+};
+
+#ifdef BPT_STATS
+#define BPT_COUNT(field, n) (counters.field += (n))
+#else
+#define BPT_COUNT(field, n) ((void)0)
+#endif
+
+// InnerM = fanout of internal nodes, LeafM = entries per leaf (defaults to the same as InnerM).
+// Layout = how keys are searched inside a node (SortedLayout / BlockedLayout, see node_layout.hpp).
+// Filter = membership filter checked before point lookups descend (NoFilter / BloomFilter<BitsPerKey>,
+// see key_filter.hpp), kept current by every insert and remove.
+// every tree allocates its nodes from one Arena: either a private one it owns (default constructor)
+// or one passed in, so a shard / thread can keep all of its trees in its own arena
+template <typename KeyType, typename ValueType, int InnerM = 256, int LeafM = InnerM, typename Layout = SortedLayout,
+          typename Filter = NoFilter>
+class BPlusTree
+{
+    static_assert(InnerM >= 3 && InnerM <= UINT16_MAX, "InnerM must fit the uint16_t key count");
+    static_assert(LeafM >= 2 && LeafM <= UINT16_MAX, "LeafM must fit the uint16_t key count");
+
+private:
+    // common header, is_leaf tells which of the two layouts follows
+    struct Node
+    {
+        bool is_leaf;
+        uint16_t num_keys; // Changed to uint16_t for packing, though alignment padding might negate this
+
+        Node(bool leaf) : is_leaf(leaf), num_keys(0)
+        {
+            // values / children are uninitialized for performance
+        }
+    };
+
+    // keys[num_keys..M) always hold the sentinel (largest key) for arithmetic keys, so the
+    // branchless kernels can compare whole vectors past num_keys without reading garbage
+    static void pad_keys(KeyType *keys, int from, int to)
+    {
+        if constexpr (has_key_sentinel<KeyType>())
+        {
+            std::fill(keys + from, keys + to, key_sentinel<KeyType>());
+        }
+    }
+
+    // per-node search index of the layout policy (empty for SortedLayout)
+    using LeafIndex = typename Layout::template Index<KeyType, LeafM>;
+    using InnerIndex = typename Layout::template Index<KeyType, InnerM>;
+
+    // leaves only carry keys + values, no child pointers
+    struct alignas(64) LeafNode : Node, LeafIndex
+    {
+        KeyType keys[LeafM];
+        ValueType values[LeafM];
+
+        // leaf chain for range scans
+        LeafNode *next;
+        LeafNode *prev;
+
+        LeafNode() : Node(true), next(nullptr), prev(nullptr)
+        {
+            pad_keys(keys, 0, LeafM);
+        }
+    };
+
+    // internal nodes only carry separators + children
+    struct alignas(64) InternalNode : Node, InnerIndex
+    {
+        KeyType keys[InnerM];
+        Node *children[InnerM + 1];
+
+        InternalNode() : Node(false)
+        {
+            pad_keys(keys, 0, InnerM);
+        }
+    };
+
+    static LeafNode *as_leaf(Node *node) { return static_cast<LeafNode *>(node); }
+    static InternalNode *as_inner(Node *node) { return static_cast<InternalNode *>(node); }
+
+    // freed nodes are threaded through their own first bytes until reused
+    struct FreeNode
+    {
+        FreeNode *next;
+    };
+
+    // minimum occupancy before a node borrows from / merges with a sibling (what a split leaves behind)
+    static constexpr int MIN_LEAF_KEYS = LeafM / 2;
+    static constexpr int MIN_INNER_KEYS = (InnerM - 1) / 2;
+
+    // start small for private arenas, chunks double as the tree grows
+    static constexpr size_t OWNED_ARENA_INITIAL_SIZE = 1ULL * 1024 * 1024;
+
+    std::unique_ptr<Arena> owned_arena; // set when the tree made its own arena
+    Arena *arena;
+
+    Node *root;
+    LeafNode *head_leaf; // leftmost leaf, start of the leaf chain
+    LeafNode *tail_leaf; // rightmost leaf, end() lives here
+
+    // per-tree recycling, checked before bumping the arena
+    FreeNode *free_leaves = nullptr;
+    FreeNode *free_inners = nullptr;
+
+    BPlusTreeCounters counters;
+
+    // filter over the live keys, plus removed keys whose bits are still set
+    using KeyFilter = typename Filter::template Set<KeyType>;
+    KeyFilter filter;
+    size_t filter_stale = 0;
+
+    // read-only copy of the upper internal levels, keys only (see enable_top_cache())
+    struct TopCache
+    {
+        std::unique_ptr<Arena> arena; // huge pages, reset by every rebuild
+        size_t max_bytes = 0;         // budget, 0 = off
+        size_t bytes = 0;
+        int levels = 0;               // mirrored levels, 0 while the tree is too small
+        bool dirty = false;           // a mirrored node split / merged, or the root changed: rebuild
+        bool last_level_change = false; // a child of a last-level node split / borrowed / merged: patch
+        KeyType *keys = nullptr;      // InnerM per node, level by level, padded like the nodes
+        uint16_t *counts = nullptr;
+        uint32_t *first_child = nullptr; // index into the next level, or into exits[] on the last one
+        size_t last_base = 0;            // index of the last mirrored level's first node
+        Node **exits = nullptr;          // InnerM + 1 slots per last-level node: the real children
+        InternalNode **sources = nullptr; // real node of each last-level node, for patching
+    };
+    TopCache top_cache;
+
+    // kept current by every mutation, stats() walks the nodes for the rest
+    size_t num_entries = 0;
+    size_t live_leaves = 0; // nodes in the tree, free-listed ones excluded
+    size_t live_inners = 0;
+    int num_levels = 1;
+
+    // fresh memory straight from the arena
+    LeafNode *bump_leaf_node()
+    {
+        live_leaves++;
+        return ::new (arena->allocate(sizeof(LeafNode))) LeafNode();
+    }
+
+    InternalNode *bump_internal_node()
+    {
+        live_inners++;
+        return ::new (arena->allocate(sizeof(InternalNode))) InternalNode();
+    }
+
+    LeafNode *new_leaf_node()
+    {
+        if (free_leaves)
+        {
+            void *mem = free_leaves;
+            free_leaves = free_leaves->next;
+            live_leaves++;
+            return ::new (mem) LeafNode();
+        }
+        return bump_leaf_node();
+    }
+
+    InternalNode *new_internal_node()
+    {
+        if (free_inners)
+        {
+            void *mem = free_inners;
+            free_inners = free_inners->next;
+            live_inners++;
+            return ::new (mem) InternalNode();
+        }
+        return bump_internal_node();
+    }
+
+    void free_node(Node *node)
+    {
+        FreeNode *slot;
+        if (node->is_leaf)
+        {
+            as_leaf(node)->~LeafNode();
+            live_leaves--;
+            slot = ::new ((void *)node) FreeNode{free_leaves};
+            free_leaves = slot;
+        }
+        else
+        {
+            as_inner(node)->~InternalNode();
+            live_inners--;
+            slot = ::new ((void *)node) FreeNode{free_inners};
+            free_inners = slot;
+        }
+    }
+
+    void init_empty()
+    {
+        head_leaf = new_leaf_node();
+        tail_leaf = head_leaf;
+        root = head_leaf;
+        num_entries = 0;
+        num_levels = 1;
+        if constexpr (KeyFilter::enabled)
+        {
+            filter.reset(0);
+            filter_stale = 0;
+        }
+        top_cache.dirty = true;
+    }
+
+    // --- KEY FILTER ---
+    // refills the filter from the leaf chain, sized for twice the live keys
+    void rebuild_filter()
+    {
+        filter.reset(2 * num_entries);
+        filter_stale = 0;
+        for (LeafNode *leaf = head_leaf; leaf; leaf = leaf->next)
+        {
+            for (int i = 0; i < leaf->num_keys; i++)
+            {
+                filter.add(leaf->keys[i]);
+            }
+        }
+    }
+
+    // after key went into the tree (new or overwritten)
+    void filter_added(KeyType key)
+    {
+        if constexpr (KeyFilter::enabled)
+        {
+            if (num_entries + filter_stale > filter.capacity())
+            {
+                rebuild_filter();
+            }
+            else
+            {
+                filter.add(key);
+            }
+        }
+    }
+
+    // the removed key keeps its bits until the next rebuild
+    void filter_removed()
+    {
+        if constexpr (KeyFilter::enabled)
+        {
+            if (++filter_stale + num_entries > filter.capacity())
+            {
+                rebuild_filter();
+            }
+        }
+    }
+
+    bool filter_may_contain(KeyType key)
+    {
+        if constexpr (KeyFilter::enabled)
+        {
+            if (!filter.may_contain(key))
+            {
+                BPT_COUNT(filter_rejects, 1);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void free_subtree(Node *node)
+    {
+        if (!node->is_leaf)
+        {
+            InternalNode *inner = as_inner(node);
+            for (int i = 0; i <= inner->num_keys; i++)
+            {
+                free_subtree(inner->children[i]);
+            }
+        }
+        free_node(node);
+    }
+
+    static int fill_bucket(int num_keys, int capacity)
+    {
+        return std::min(BPlusTreeStats::FILL_BUCKETS - 1, num_keys * BPlusTreeStats::FILL_BUCKETS / capacity);
+    }
+
+    void collect_stats(const Node *node, int depth, BPlusTreeStats &st, size_t &leaf_keys, size_t &inner_keys) const
+    {
+        st.nodes_per_level[depth]++;
+        if (node->is_leaf)
+        {
+            st.leaf_nodes++;
+            leaf_keys += node->num_keys;
+            st.leaf_fill[fill_bucket(node->num_keys, LeafM - 1)]++;
+            return;
+        }
+        const InternalNode *inner = static_cast<const InternalNode *>(node);
+        st.internal_nodes++;
+        inner_keys += inner->num_keys;
+        st.internal_fill[fill_bucket(inner->num_keys, InnerM - 1)]++;
+        for (int i = 0; i <= inner->num_keys; i++)
+        {
+            collect_stats(inner->children[i], depth + 1, st, leaf_keys, inner_keys);
+        }
+    }
+
+    // pull the first lines of keys[] and values[] of a leaf into cache
+    static void prefetch_leaf(const LeafNode *leaf)
+    {
+        if (!leaf)
+            return;
+        prefetch_t0(leaf);
+        prefetch_t0((const char *)leaf->keys + 64);
+        prefetch_t0(leaf->values);
+        prefetch_t0((const char *)leaf->values + 64);
+    }
+
+    // descend to the leaf that would contain key (same routing as findLinear)
+    LeafNode *find_leaf(KeyType key) const
+    {
+        Node *curr = root;
+        while (!curr->is_leaf)
+        {
+            InternalNode *inner = as_inner(curr);
+            int lo = 0, hi = inner->num_keys;
+            // first key > input
+            while (lo < hi)
+            {
+                int mid = lo + (hi - lo) / 2;
+                if (inner->keys[mid] <= key)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            curr = inner->children[lo];
+        }
+        return as_leaf(curr);
+    }
+
+    // first few lines of a node we are about to descend into (header + start of keys[])
+    static void prefetch_node(const Node *node)
+    {
+        prefetch_t0(node);
+        prefetch_t0((const char *)node + 64);
+        prefetch_t0((const char *)node + 128);
+        prefetch_t0((const char *)node + 192);
+    }
+
+    // --- NODE SEARCH ---
+    // kernels come from KeySearch<KeyType> (node_search.hpp): SIMD for 32/64-bit ints and floats,
+    // binary search for everything else
+    using Search = KeySearch<KeyType>;
+
+    using Kernels = SearchKernels<KeyType>;
+
+    // child index: first key > input, num_keys if none
+    static int search_inner(const Kernels &kern, const InternalNode *inner, KeyType key)
+    {
+        return inner->InnerIndex::upper_bound(kern, inner->keys, inner->num_keys, key);
+    }
+
+    // exact match in a leaf: slot index or -1
+    static int search_leaf(const Kernels &kern, const LeafNode *leaf, KeyType key)
+    {
+        return leaf->LeafIndex::find(kern, leaf->keys, leaf->num_keys, key);
+    }
+
+    // --- TOP-LEVELS CACHE ---
+    // levels are mirrored from the root down, the last one may be the bottom internal level. Splits,
+    // borrows and merges of mirrored internal nodes and root changes mark the mirror dirty (rebuilt
+    // whole, rare). One of a node right below the mirror (a leaf, or an internal node when the
+    // mirror stops higher up) only changes its parent on the last mirrored level: a single-key
+    // mutator re-copies just that node, found by routing its key through the mirror (still valid:
+    // the node's own range didn't move). Anything deeper leaves the mirror alone. Mutators refresh
+    // before returning, never a lookup, since readers may share the tree
+
+    // a node at depth (root = 0) split, borrowed or merged
+    void top_cache_restructured(int depth)
+    {
+        TopCache &tc = top_cache;
+        if (depth < tc.levels)
+        {
+            tc.dirty = true;
+        }
+        else if (depth == tc.levels)
+        {
+            tc.last_level_change = true;
+        }
+    }
+
+    // after operations that may restructure many nodes
+    void refresh_top_cache()
+    {
+        TopCache &tc = top_cache;
+        if (tc.max_bytes && (tc.dirty || (tc.last_level_change && tc.levels > 0)))
         {
-            throw std::runtime_error("Arena out of memory");
+            rebuild_top_cache();
         }
+        tc.last_level_change = false;
+    }
+
+    // after an insert / remove of key
+    void refresh_top_cache(KeyType key)
+    {
+        TopCache &tc = top_cache;
+        if (tc.max_bytes && tc.dirty)
+        {
+            rebuild_top_cache();
+        }
+        else if (tc.max_bytes && tc.last_level_change && tc.levels > 0)
+        {
+            patch_top_cache(key);
+        }
+        tc.last_level_change = false;
+    }
+
+    // mirror node n <- its real node, n on the last level
+    void copy_last_level_node(size_t n)
+    {
+        TopCache &tc = top_cache;
+        const InternalNode *inner = tc.sources[n - tc.last_base];
+        std::copy(inner->keys, inner->keys + InnerM, tc.keys + n * InnerM);
+        tc.counts[n] = inner->num_keys;
+        std::copy(inner->children, inner->children + inner->num_keys + 1, tc.exits + tc.first_child[n]);
+    }
+
+    void patch_top_cache(KeyType key)
+    {
+        const Kernels &kern = Search::active();
+        const TopCache &tc = top_cache;
+        uint32_t n = 0;
+        for (int l = 0; l + 1 < tc.levels; l++)
+        {
+            n = tc.first_child[n] + kern.upper_bound(tc.keys + (size_t)n * InnerM, tc.counts[n], key);
+        }
+        copy_last_level_node(n);
+    }
+
+    void rebuild_top_cache()
+    {
+        static constexpr size_t node_bytes = InnerM * sizeof(KeyType) + sizeof(uint16_t) + sizeof(uint32_t);
+        static constexpr size_t last_node_bytes = (InnerM + 1) * sizeof(Node *) + sizeof(InternalNode *);
+        TopCache &tc = top_cache;
+        BPT_COUNT(top_cache_rebuilds, 1);
+        tc.dirty = false;
+        tc.last_level_change = false;
+        tc.levels = 0;
+        tc.bytes = 0;
+        tc.arena->reset();
+
+        // level by level from the root while the next level still fits the budget as the last one
+        std::vector<std::vector<InternalNode *>> mirrored;
+        std::vector<InternalNode *> level;
+        size_t nodes = 0;
+        if (num_levels >= 2)
+        {
+            level.push_back(as_inner(root));
+        }
+        while ((int)mirrored.size() < num_levels - 1)
+        {
+            if ((nodes + level.size()) * node_bytes + level.size() * last_node_bytes > tc.max_bytes)
+            {
+                break;
+            }
+            nodes += level.size();
+
+            std::vector<InternalNode *> next;
+            if ((int)mirrored.size() + 1 < num_levels - 1)
+            {
+                for (InternalNode *inner : level)
+                {
+                    for (int i = 0; i <= inner->num_keys; i++)
+                    {
+                        next.push_back(as_inner(inner->children[i]));
+                    }
+                }
+            }
+            mirrored.push_back(std::move(level));
+            level = std::move(next);
+        }
+        if (mirrored.empty())
+        {
+            return;
+        }
+
+        size_t last_nodes = mirrored.back().size();
+        tc.keys = (KeyType *)tc.arena->allocate(nodes * InnerM * sizeof(KeyType));
+        tc.counts = (uint16_t *)tc.arena->allocate(nodes * sizeof(uint16_t));
+        tc.first_child = (uint32_t *)tc.arena->allocate(nodes * sizeof(uint32_t));
+        tc.exits = (Node **)tc.arena->allocate(last_nodes * (InnerM + 1) * sizeof(Node *));
+        tc.sources = (InternalNode **)tc.arena->allocate(last_nodes * sizeof(InternalNode *));
+        tc.last_base = nodes - last_nodes;
+        tc.levels = (int)mirrored.size();
+
+        size_t n = 0;
+        for (size_t l = 0; l + 1 < mirrored.size(); l++)
+        {
+            size_t child = n + mirrored[l].size();
+            for (InternalNode *inner : mirrored[l])
+            {
+                std::copy(inner->keys, inner->keys + InnerM, tc.keys + n * InnerM);
+                tc.counts[n] = inner->num_keys;
+                tc.first_child[n] = (uint32_t)child;
+                child += inner->num_keys + 1;
+                n++;
+            }
+        }
+        // last level: fixed InnerM + 1 exit slots per node, so patching one never shifts the others
+        for (size_t j = 0; j < last_nodes; j++, n++)
+        {
+            tc.sources[j] = mirrored.back()[j];
+            tc.first_child[n] = (uint32_t)(j * (InnerM + 1));
+            copy_last_level_node(n);
+        }
+        tc.bytes = nodes * node_bytes + last_nodes * last_node_bytes;
+    }
+
+    // first real node of a descent: resolved through the mirror when there is one
+    Node *top_cache_descend(const Kernels &kern, KeyType key) const
+    {
+        const TopCache &tc = top_cache;
+        if (tc.levels == 0)
+        {
+            return root;
+        }
+        uint32_t n = 0;
+        for (int l = 0; l + 1 < tc.levels; l++)
+        {
+            n = tc.first_child[n] + kern.upper_bound(tc.keys + (size_t)n * InnerM, tc.counts[n], key);
+        }
+        return tc.exits[tc.first_child[n] + kern.upper_bound(tc.keys + (size_t)n * InnerM, tc.counts[n], key)];
+    }
+
+    // refresh the layout's index after keys[] of a node changed
+    static void reindex(LeafNode *leaf)
+    {
+        leaf->LeafIndex::rebuild(leaf->keys, leaf->num_keys);
+    }
+
+    static void reindex(InternalNode *inner)
+    {
+        inner->InnerIndex::rebuild(inner->keys, inner->num_keys);
+    }
+
+    // moves src[0..count) to dst (ranges may overlap): one memmove for trivially copyable
+    // types, element-wise moves otherwise
+    template <typename T>
+    static void move_slots(T *dst, T *src, int count)
+    {
+        if (count <= 0)
+            return;
+        if constexpr (std::is_trivially_copyable<T>::value)
+        {
+            std::memmove(dst, src, count * sizeof(T));
+        }
+        else if (dst < src)
+        {
+            std::move(src, src + count, dst);
+        }
+        else
+        {
+            std::move_backward(src, src + count, dst + count);
+        }
+    }
+
+    // how insert_recursive finds the slot in each node
+    enum class InsertPath
+    {
+        Linear, // scalar scan + one-element-at-a-time shifts (original)
+        Binary, // std::upper_bound + bulk shifts
+        Kernel  // the read path's node search (SIMD / layout index) + bulk shifts
+    };
+
+    // first key > input (leaves and internal nodes alike, a leaf hit is the slot before it)
+    template <InsertPath Path>
+    static int insert_upper_bound(const Kernels &kern, const Node *node, const KeyType *keys, KeyType key)
+    {
+        if constexpr (Path == InsertPath::Binary)
+        {
+            return scalar_search::binary_upper_bound(keys, node->num_keys, key);
+        }
+        else if (node->is_leaf)
+        {
+            return static_cast<const LeafNode *>(node)->LeafIndex::upper_bound(kern, keys, node->num_keys, key);
+        }
+        else
+        {
+            return search_inner(kern, static_cast<const InternalNode *>(node), key);
+        }
+    }
+
+    // core of insertion algorithm
+    template <InsertPath Path>
+    void insert_recursive(const Kernels &kern, Node *node, int depth, KeyType key, ValueType value, Node *&new_sibling,
+                          KeyType &median)
+    {
+        // 1. find index to insert
+        // leaves: first key >= input, internal: first key > input (same routing as the find* paths)
+        int i = 0;
+        BPT_COUNT(insert_nodes, 1);
+
+        // 2. leaf logic
+        if (node->is_leaf)
+        {
+            LeafNode *leaf = as_leaf(node);
+            if constexpr (Path == InsertPath::Linear)
+            {
+                while (i < leaf->num_keys && key > leaf->keys[i])
+                {
+                    i++;
+                }
+            }
+            else
+            {
+                // keys are unique, so only the slot before the upper bound can match
+                i = insert_upper_bound<Path>(kern, leaf, leaf->keys, key);
+                if (i > 0 && leaf->keys[i - 1] == key)
+                {
+                    i--;
+                }
+            }
+
+            // update existing value
+            if (i < leaf->num_keys && leaf->keys[i] == key)
+            {
+                leaf->values[i] = value;
+                return;
+            }
+
+            // insert into arrays
+            // shift elements to right
+            BPT_COUNT(keys_shifted, leaf->num_keys - i);
+            if constexpr (Path == InsertPath::Linear)
+            {
+                for (int k = leaf->num_keys; k > i; k--) {
+                    leaf->keys[k] = leaf->keys[k-1];
+                    leaf->values[k] = leaf->values[k-1];
+                }
+            }
+            else
+            {
+                move_slots(leaf->keys + i + 1, leaf->keys + i, leaf->num_keys - i);
+                move_slots(leaf->values + i + 1, leaf->values + i, leaf->num_keys - i);
+            }
+            leaf->keys[i] = key;
+            leaf->values[i] = value;
+            leaf->num_keys++;
+            num_entries++;
+            reindex(leaf);
+
+            // check Split
+            if (leaf->num_keys >= LeafM)
+            {
+                split_leaf(leaf, new_sibling, median);
+            }
+            return;
+        }
+
+        InternalNode *inner = as_inner(node);
+        if constexpr (Path == InsertPath::Linear)
+        {
+            while (i < inner->num_keys && key >= inner->keys[i])
+            {
+                i++;
+            }
+        }
+        else
+        {
+            i = insert_upper_bound<Path>(kern, inner, inner->keys, key);
+        }
+
+        // 3. rebalancing internal nodes
+        Node *child_sibling = nullptr;
+        KeyType child_median = KeyType();
+
+        insert_recursive<Path>(kern, inner->children[i], depth + 1, key, value, child_sibling, child_median);
+
+        if (child_sibling != nullptr)
+        {
+            // child split! ==> insert median and pointer into THIS node
+            // shift half keys to the right
+            BPT_COUNT(keys_shifted, inner->num_keys - i);
+            if constexpr (Path == InsertPath::Linear)
+            {
+                for (int k = inner->num_keys; k > i; k--) {
+                    inner->keys[k] = inner->keys[k-1];
+                }
+
+                for (int k = inner->num_keys + 1; k > i + 1; k--) {
+                    inner->children[k] = inner->children[k-1];
+                }
+            }
+            else
+            {
+                move_slots(inner->keys + i + 1, inner->keys + i, inner->num_keys - i);
+                move_slots(inner->children + i + 2, inner->children + i + 1, inner->num_keys - i);
+            }
+
+            inner->keys[i] = child_median;
+            inner->children[i + 1] = child_sibling;
+            inner->num_keys++;
+            reindex(inner);
+
+            if (inner->num_keys >= InnerM)
+            {
+                split_internal(inner, depth, new_sibling, median);
+            }
+        }
+    }
+
+    template <InsertPath Path>
+    void insert_with(KeyType key, ValueType value)
+    {
+        Node *new_child = nullptr;
+        KeyType median = KeyType();
+        BPT_COUNT(inserts, 1);
+
+        insert_recursive<Path>(Search::active(), root, 0, key, value, new_child, median);
+
+        if (new_child != nullptr)
+        {
+            InternalNode *new_root = new_internal_node();
+            new_root->keys[0] = median;
+            new_root->children[0] = root;
+            new_root->children[1] = new_child;
+            new_root->num_keys = 1;
+            reindex(new_root);
+            root = new_root;
+            num_levels++;
+            top_cache.dirty = true;
+        }
+        filter_added(key);
+        refresh_top_cache(key);
+    }
+
+    // --- BATCHED MERGE ---
+    // (separator, new right sibling) left behind by splits, ascending
+    using SplitList = std::vector<std::pair<KeyType, Node *>>;
+
+    // node has been split into node + the siblings in out[base..): the piece whose range holds key
+    static Node *split_piece(Node *node, const SplitList &out, size_t base, KeyType key)
+    {
+        auto it = std::upper_bound(out.begin() + base, out.end(), key,
+                                   [](KeyType k, const auto &entry) { return k < entry.first; });
+        return it == out.begin() + base ? node : std::prev(it)->second;
+    }
+
+    // a piece further left can split after one to its right did, so keep out[base..) sorted
+    static void add_split_piece(SplitList &out, size_t base, KeyType median, Node *sibling)
+    {
+        auto it = std::upper_bound(out.begin() + base, out.end(), median,
+                                   [](KeyType k, const auto &entry) { return k < entry.first; });
+        out.insert(it, std::make_pair(median, sibling));
+    }
+
+    // applies the sorted run [first, last) below node, visiting it once: an internal node hands
+    // every child its sub-run and then takes in all of the children's splits. Splits of node
+    // itself go to out (node keeps the leftmost piece)
+    template <typename Iter>
+    void merge_recursive(const Kernels &kern, Node *node, int depth, Iter first, Iter last, SplitList &out)
+    {
+        BPT_COUNT(insert_nodes, 1);
+        size_t base = out.size(); // out may already hold splits of node's left siblings
+
+        if (node->is_leaf)
+        {
+            LeafNode *cur = as_leaf(node);
+            for (; first != last; ++first)
+            {
+                KeyType key = first->first;
+                BPT_COUNT(inserts, 1);
+                if (out.size() > base)
+                {
+                    cur = as_leaf(split_piece(node, out, base, key));
+                }
+
+                int i = cur->LeafIndex::upper_bound(kern, cur->keys, cur->num_keys, key);
+                if (i > 0 && cur->keys[i - 1] == key)
+                {
+                    cur->values[i - 1] = first->second;
+                    continue;
+                }
+
+                BPT_COUNT(keys_shifted, cur->num_keys - i);
+                move_slots(cur->keys + i + 1, cur->keys + i, cur->num_keys - i);
+                move_slots(cur->values + i + 1, cur->values + i, cur->num_keys - i);
+                cur->keys[i] = key;
+                cur->values[i] = first->second;
+                cur->num_keys++;
+                num_entries++;
+                reindex(cur);
+
+                if (cur->num_keys >= LeafM)
+                {
+                    Node *sibling = nullptr;
+                    KeyType median = KeyType();
+                    split_leaf(cur, sibling, median);
+                    add_split_piece(out, base, median, sibling);
+                }
+            }
+            return;
+        }
+
+        InternalNode *inner = as_inner(node);
+        SplitList child_splits;
+        // the next key picks its child, which takes every key below that child's upper separator
+        while (first != last)
+        {
+            int c = search_inner(kern, inner, first->first);
+            Iter end = last;
+            if (c < inner->num_keys)
+            {
+                KeyType sep = inner->keys[c];
+                end = std::lower_bound(std::next(first), last, sep,
+                                       [](const auto &entry, KeyType k) { return entry.first < k; });
+            }
+            merge_recursive(kern, inner->children[c], depth + 1, first, end, child_splits);
+            first = end;
+        }
+        add_separators(kern, inner, depth, child_splits, out);
+    }
+
+    // inserts ascending (separator, right child) pairs into node, splitting it as often as needed
+    void add_separators(const Kernels &kern, InternalNode *node, int depth, const SplitList &pending, SplitList &out)
+    {
+        size_t base = out.size();
+        InternalNode *cur = node;
+        for (const auto &entry : pending)
+        {
+            if (out.size() > base)
+            {
+                cur = as_inner(split_piece(node, out, base, entry.first));
+            }
+
+            int i = search_inner(kern, cur, entry.first);
+            BPT_COUNT(keys_shifted, cur->num_keys - i);
+            move_slots(cur->keys + i + 1, cur->keys + i, cur->num_keys - i);
+            move_slots(cur->children + i + 2, cur->children + i + 1, cur->num_keys - i);
+            cur->keys[i] = entry.first;
+            cur->children[i + 1] = entry.second;
+            cur->num_keys++;
+            reindex(cur);
+
+            if (cur->num_keys >= InnerM)
+            {
+                Node *sibling = nullptr;
+                KeyType median = KeyType();
+                split_internal(cur, depth, sibling, median);
+                add_split_piece(out, base, median, sibling);
+            }
+        }
+    }
+
+    // --- CURSOR INSERTS ---
+    // deep enough for any tree an arena can hold (height grows with log_{M/2} of the key count)
+    static constexpr int MAX_CURSOR_DEPTH = 64;
+
+    // root-to-leaf path of the last batched insert. Level i went through child slot[i] of
+    // nodes[i]; upper[i] is that child's exclusive upper fence (bounded[i] false = +infinity)
+    struct InsertCursor
+    {
+        InternalNode *nodes[MAX_CURSOR_DEPTH];
+        int slot[MAX_CURSOR_DEPTH];
+        KeyType upper[MAX_CURSOR_DEPTH];
+        bool bounded[MAX_CURSOR_DEPTH];
+        int depth = 0; // internal levels on the path
+        LeafNode *leaf = nullptr;
+    };
+
+    // right-biased split point for append patterns: the old node keeps ~90%
+    static constexpr int append_split(int num_keys, int m)
+    {
+        return std::max(1, std::min(num_keys - 1, m * 9 / 10));
+    }
+
+    // moves the cursor to the leaf for key. keys only ascend, so the path is kept up to the
+    // deepest level whose subtree still covers key and re-descended from there
+    void cursor_seek(const Kernels &kern, InsertCursor &cur, KeyType key)
+    {
+        int level = 0;
+        Node *node = root;
+        if (cur.leaf)
+        {
+            if (cur.depth == 0 || !cur.bounded[cur.depth - 1] || key < cur.upper[cur.depth - 1])
+            {
+                return; // still inside the current leaf
+            }
+            // nodes[level] covers key when its own fence (the level above's) is above key
+            level = cur.depth - 1;
+            while (level > 0 && cur.bounded[level - 1] && !(key < cur.upper[level - 1]))
+            {
+                level--;
+            }
+            node = cur.nodes[level];
+        }
+
+        while (!node->is_leaf)
+        {
+            BPT_COUNT(insert_nodes, 1);
+            InternalNode *inner = as_inner(node);
+            int c = search_inner(kern, inner, key);
+            cur.nodes[level] = inner;
+            cur.slot[level] = c;
+            if (c < inner->num_keys)
+            {
+                cur.upper[level] = inner->keys[c];
+                cur.bounded[level] = true;
+            }
+            else if (level > 0)
+            {
+                cur.upper[level] = cur.upper[level - 1];
+                cur.bounded[level] = cur.bounded[level - 1];
+            }
+            else
+            {
+                cur.bounded[level] = false;
+            }
+            node = inner->children[c];
+            level++;
+        }
+        BPT_COUNT(insert_nodes, 1);
+        cur.depth = level;
+        cur.leaf = as_leaf(node);
+    }
+
+    // inserts into the cursor's leaf, splitting up the cached path when it fills. A split
+    // invalidates the cursor (the next key re-descends from the root)
+    void cursor_insert(const Kernels &kern, InsertCursor &cur, KeyType key, const ValueType &value)
+    {
+        BPT_COUNT(inserts, 1);
+        LeafNode *leaf = cur.leaf;
+        int i = leaf->LeafIndex::upper_bound(kern, leaf->keys, leaf->num_keys, key);
+        if (i > 0 && leaf->keys[i - 1] == key)
+        {
+            leaf->values[i - 1] = value;
+            return;
+        }
+
+        BPT_COUNT(keys_shifted, leaf->num_keys - i);
+        bool append = i == leaf->num_keys;
+        move_slots(leaf->keys + i + 1, leaf->keys + i, leaf->num_keys - i);
+        move_slots(leaf->values + i + 1, leaf->values + i, leaf->num_keys - i);
+        leaf->keys[i] = key;
+        leaf->values[i] = value;
+        leaf->num_keys++;
+        num_entries++;
+        reindex(leaf);
+
+        if (leaf->num_keys < LeafM)
+        {
+            return;
+        }
+
+        Node *sibling = nullptr;
+        KeyType median = KeyType();
+        split_leaf(leaf, sibling, median, append ? append_split(leaf->num_keys, LeafM) : LeafM / 2);
+
+        // hand the split up the cached path
+        int level = cur.depth - 1;
+        for (; level >= 0 && sibling; level--)
+        {
+            InternalNode *parent = cur.nodes[level];
+            int c = cur.slot[level];
+            BPT_COUNT(keys_shifted, parent->num_keys - c);
+            append = c == parent->num_keys;
+            move_slots(parent->keys + c + 1, parent->keys + c, parent->num_keys - c);
+            move_slots(parent->children + c + 2, parent->children + c + 1, parent->num_keys - c);
+            parent->keys[c] = median;
+            parent->children[c + 1] = sibling;
+            parent->num_keys++;
+            reindex(parent);
+
+            sibling = nullptr;
+            if (parent->num_keys >= InnerM)
+            {
+                split_internal(parent, level, sibling, median,
+                               append ? append_split(parent->num_keys - 1, InnerM) : InnerM / 2);
+            }
+        }
+
+        if (sibling)
+        {
+            InternalNode *new_root = new_internal_node();
+            new_root->keys[0] = median;
+            new_root->children[0] = root;
+            new_root->children[1] = sibling;
+            new_root->num_keys = 1;
+            reindex(new_root);
+            root = new_root;
+            num_levels++;
+            top_cache.dirty = true;
+        }
+        cur.leaf = nullptr;
+    }
+
+    // keys of [first, last) must not decrease
+    template <typename Iter>
+    void insert_ascending(Iter first, Iter last)
+    {
+        const Kernels &kern = Search::active();
+        InsertCursor cur;
+        for (; first != last; ++first)
+        {
+            cursor_seek(kern, cur, first->first);
+            cursor_insert(kern, cur, first->first, first->second);
+            filter_added(first->first);
+        }
+        refresh_top_cache();
+    }
+
+    // --- SPLITTING LOGIC ---
+    // mid = keys the old node keeps (half by default, insert_batch keeps more on appends)
+    void split_leaf(LeafNode *node, Node *&new_sibling, KeyType &median, int mid = LeafM / 2)
+    {
+        top_cache_restructured(num_levels - 1);
+        LeafNode *new_leaf = new_leaf_node();
+        new_sibling = new_leaf;
+
+        // move right half
+        int num_moving = node->num_keys - mid;
+        BPT_COUNT(leaf_splits, 1);
+        BPT_COUNT(keys_shifted, num_moving);
+        move_slots(new_leaf->keys, node->keys + mid, num_moving);
+        move_slots(new_leaf->values, node->values + mid, num_moving);
+        new_leaf->num_keys = num_moving;
+
+        // update the number of entries in old node
+        node->num_keys = mid;
+        pad_keys(node->keys, mid, mid + num_moving);
+
+        // link new leaf in right after the old one
+        new_leaf->prev = node;
+        new_leaf->next = node->next;
+        if (node->next)
+            node->next->prev = new_leaf;
+        else
+            tail_leaf = new_leaf;
+        node->next = new_leaf;
+        reindex(node);
+        reindex(new_leaf);
+
+        // leaf split copies up
+        median = new_leaf->keys[0];
+    }
+
+    // keys[mid] moves up, the old node keeps keys[0..mid). depth = node's (root = 0)
+    void split_internal(InternalNode *node, int depth, Node *&new_sibling, KeyType &median, int mid = InnerM / 2)
+    {
+        top_cache_restructured(depth);
+        InternalNode *new_node = new_internal_node();
+        new_sibling = new_node;
+
+        // the key at mid moves UP
+        median = node->keys[mid];
+
+        // move right half keys (excluding mid)
+        int num_keys_moving = node->num_keys - (mid + 1);
+        BPT_COUNT(inner_splits, 1);
+        BPT_COUNT(keys_shifted, num_keys_moving);
+        move_slots(new_node->keys, node->keys + mid + 1, num_keys_moving);
+        new_node->num_keys = num_keys_moving;
+
+        // move right half children
+        int num_children_moving = num_keys_moving + 1;
+        move_slots(new_node->children, node->children + mid + 1, num_children_moving);
+
+        // update the entries in old node
+        pad_keys(node->keys, mid, node->num_keys);
+        node->num_keys = mid;
+        reindex(node);
+        reindex(new_node);
+    }
+
+    // --- BULK BUILD ---
+    // how many items land in each of `groups` nodes when `count` is spread evenly
+    static size_t share(size_t count, size_t groups, size_t g)
+    {
+        return count / groups + (g < count % groups ? 1 : 0);
+    }
+
+    // builds a fresh tree from n sorted, unique pairs starting at first.
+    // bumps the arena directly (not the free lists) so the new nodes are contiguous
+    template <typename Iter>
+    void build_bottom_up(Iter first, size_t n, double fill_factor)
+    {
+        // keys at rest are capped at M - 1 (a node holding M keys splits)
+        size_t per_leaf = std::max<size_t>(1, (size_t)(fill_factor * (LeafM - 1)));
+        size_t per_inner = std::max<size_t>(3, std::min<size_t>(InnerM, (size_t)(fill_factor * (InnerM - 1)) + 1));
+
+        num_entries = n;
+        num_levels = 1;
+        if (n == 0)
+        {
+            head_leaf = bump_leaf_node();
+            tail_leaf = head_leaf;
+            root = head_leaf;
+            return;
+        }
+
+        // 1. leaves, spread evenly so the last one isn't left nearly empty
+        size_t num_leaves = (n + per_leaf - 1) / per_leaf;
+        std::vector<Node *> level(num_leaves);
+        std::vector<KeyType> level_min(num_leaves); // smallest key under each node, becomes the separator
+
+        LeafNode *prev_leaf = nullptr;
+        Iter it = first;
+        for (size_t l = 0; l < num_leaves; l++)
+        {
+            LeafNode *leaf = bump_leaf_node();
+            size_t cnt = share(n, num_leaves, l);
+            for (size_t k = 0; k < cnt; k++, ++it)
+            {
+                leaf->keys[k] = it->first;
+                leaf->values[k] = it->second;
+            }
+            leaf->num_keys = (uint16_t)cnt;
+            reindex(leaf);
+
+            leaf->prev = prev_leaf;
+            if (prev_leaf)
+                prev_leaf->next = leaf;
+            prev_leaf = leaf;
+
+            level[l] = leaf;
+            level_min[l] = leaf->keys[0];
+        }
+        head_leaf = as_leaf(level.front());
+        tail_leaf = as_leaf(level.back());
+
+        // 2. internal levels until a single node is left
+        while (level.size() > 1)
+        {
+            size_t count = level.size();
+            size_t num_parents = (count + per_inner - 1) / per_inner;
+            std::vector<Node *> parents(num_parents);
+            std::vector<KeyType> parents_min(num_parents);
+
+            size_t c = 0;
+            for (size_t p = 0; p < num_parents; p++)
+            {
+                InternalNode *inner = bump_internal_node();
+                size_t num_children = share(count, num_parents, p);
+
+                inner->children[0] = level[c];
+                for (size_t k = 1; k < num_children; k++)
+                {
+                    inner->keys[k - 1] = level_min[c + k];
+                    inner->children[k] = level[c + k];
+                }
+                inner->num_keys = (uint16_t)(num_children - 1);
+                reindex(inner);
+
+                parents[p] = inner;
+                parents_min[p] = level_min[c];
+                c += num_children;
+            }
+
+            level.swap(parents);
+            level_min.swap(parents_min);
+            num_levels++;
+        }
+
+        root = level[0];
+    }
+
+    // --- DELETION ---
+    // returns true if the key was found; parents repair any child left below minimum occupancy
+    // same node search as the read path, one bulk shift to close the gap
+    bool remove_recursive(const Kernels &kern, Node *node, KeyType key, int depth)
+    {
+        if (node->is_leaf)
+        {
+            LeafNode *leaf = as_leaf(node);
+            int k = search_leaf(kern, leaf, key);
+            if (k < 0)
+            {
+                return false;
+            }
+            move_slots(leaf->keys + k, leaf->keys + k + 1, leaf->num_keys - k - 1);
+            move_slots(leaf->values + k, leaf->values + k + 1, leaf->num_keys - k - 1);
+            leaf->num_keys--;
+            pad_keys(leaf->keys, leaf->num_keys, leaf->num_keys + 1);
+            reindex(leaf);
+            return true;
+        }
+
+        InternalNode *inner = as_inner(node);
+        int i = search_inner(kern, inner, key);
+
+        if (!remove_recursive(kern, inner->children[i], key, depth + 1))
+        {
+            return false;
+        }
+
+        // internal balancing
+        Node *child = inner->children[i];
+        int min_keys = child->is_leaf ? MIN_LEAF_KEYS : MIN_INNER_KEYS;
+        if (child->num_keys < min_keys)
+        {
+            fix_underflow(inner, i, depth + 1);
+        }
+        return true;
+    }
+
+    // children[i] of parent dropped below minimum: borrow one entry from a sibling that can
+    // spare it, otherwise merge with a sibling (always folding the right node into the left one).
+    // depth = the children's (root = 0)
+    void fix_underflow(InternalNode *parent, int i, int depth)
+    {
+        Node *child = parent->children[i];
+        Node *left = i > 0 ? parent->children[i - 1] : nullptr;
+        Node *right = i < parent->num_keys ? parent->children[i + 1] : nullptr;
+
+        if (child->is_leaf)
+        {
+            if (left && left->num_keys > MIN_LEAF_KEYS)
+            {
+                borrow_from_left_leaf(parent, i);
+            }
+            else if (right && right->num_keys > MIN_LEAF_KEYS)
+            {
+                borrow_from_right_leaf(parent, i);
+            }
+            else if (left)
+            {
+                merge_leaves(parent, i - 1);
+            }
+            else if (right)
+            {
+                merge_leaves(parent, i);
+            }
+            return;
+        }
+
+        if (left && left->num_keys > MIN_INNER_KEYS)
+        {
+            borrow_from_left_internal(parent, i, depth);
+        }
+        else if (right && right->num_keys > MIN_INNER_KEYS)
+        {
+            borrow_from_right_internal(parent, i, depth);
+        }
+        else if (left)
+        {
+            merge_internals(parent, i - 1, depth);
+        }
+        else if (right)
+        {
+            merge_internals(parent, i, depth);
+        }
+    }
+
+    void borrow_from_left_leaf(InternalNode *parent, int i)
+    {
+        top_cache_restructured(num_levels - 1);
+        LeafNode *child = as_leaf(parent->children[i]);
+        LeafNode *left = as_leaf(parent->children[i - 1]);
+
+        move_slots(child->keys + 1, child->keys, child->num_keys);
+        move_slots(child->values + 1, child->values, child->num_keys);
+        child->keys[0] = left->keys[left->num_keys - 1];
+        child->values[0] = left->values[left->num_keys - 1];
+        child->num_keys++;
+        left->num_keys--;
+        pad_keys(left->keys, left->num_keys, left->num_keys + 1);
+
+        // child has a new smallest key
+        parent->keys[i - 1] = child->keys[0];
+        reindex(child);
+        reindex(left);
+        reindex(parent);
+    }
+
+    void borrow_from_right_leaf(InternalNode *parent, int i)
+    {
+        top_cache_restructured(num_levels - 1);
+        LeafNode *child = as_leaf(parent->children[i]);
+        LeafNode *right = as_leaf(parent->children[i + 1]);
+
+        child->keys[child->num_keys] = right->keys[0];
+        child->values[child->num_keys] = right->values[0];
+        child->num_keys++;
+
+        move_slots(right->keys, right->keys + 1, right->num_keys - 1);
+        move_slots(right->values, right->values + 1, right->num_keys - 1);
+        right->num_keys--;
+        pad_keys(right->keys, right->num_keys, right->num_keys + 1);
+
+        // right has a new smallest key
+        parent->keys[i] = right->keys[0];
+        reindex(child);
+        reindex(right);
+        reindex(parent);
+    }
 
-        void *ptr = memory + offset;
-        offset += aligned_bytes;
-        return ptr;
+    void borrow_from_left_internal(InternalNode *parent, int i, int depth)
+    {
+        top_cache_restructured(depth);
+        InternalNode *child = as_inner(parent->children[i]);
+        InternalNode *left = as_inner(parent->children[i - 1]);
+
+        move_slots(child->keys + 1, child->keys, child->num_keys);
+        move_slots(child->children + 1, child->children, child->num_keys + 1);
+
+        // separator rotates down, left's last key rotates up
+        child->keys[0] = parent->keys[i - 1];
+        child->children[0] = left->children[left->num_keys];
+        child->num_keys++;
+
+        parent->keys[i - 1] = left->keys[left->num_keys - 1];
+        left->num_keys--;
+        pad_keys(left->keys, left->num_keys, left->num_keys + 1);
+        reindex(child);
+        reindex(left);
+        reindex(parent);
     }
 
-    size_t get_used_memory() const
+    void borrow_from_right_internal(InternalNode *parent, int i, int depth)
     {
-        return offset;
+        top_cache_restructured(depth);
+        InternalNode *child = as_inner(parent->children[i]);
+        InternalNode *right = as_inner(parent->children[i + 1]);
+
+        // separator rotates down, right's first key rotates up
+        child->keys[child->num_keys] = parent->keys[i];
+        child->children[child->num_keys + 1] = right->children[0];
+        child->num_keys++;
+
+        parent->keys[i] = right->keys[0];
+
+        move_slots(right->keys, right->keys + 1, right->num_keys - 1);
+        move_slots(right->children, right->children + 1, right->num_keys);
+        right->num_keys--;
+        pad_keys(right->keys, right->num_keys, right->num_keys + 1);
+        reindex(child);
+        reindex(right);
+        reindex(parent);
     }
 
-    size_t get_capacity() const
+    // drop separator keys[idx] and the pointer to its right child from an internal node
+    static void remove_separator(InternalNode *node, int idx)
     {
-        return capacity;
+        move_slots(node->keys + idx, node->keys + idx + 1, node->num_keys - idx - 1);
+        move_slots(node->children + idx + 1, node->children + idx + 2, node->num_keys - idx - 1);
+        node->num_keys--;
+        pad_keys(node->keys, node->num_keys, node->num_keys + 1);
+        reindex(node);
     }
 
-    void reset()
+    // folds children[idx + 1] into children[idx]
+    void merge_leaves(InternalNode *parent, int idx)
     {
-        offset = 0;
+        top_cache_restructured(num_levels - 1);
+        LeafNode *left = as_leaf(parent->children[idx]);
+        LeafNode *right = as_leaf(parent->children[idx + 1]);
+
+        move_slots(left->keys + left->num_keys, right->keys, right->num_keys);
+        move_slots(left->values + left->num_keys, right->values, right->num_keys);
+        left->num_keys += right->num_keys;
+        reindex(left);
+
+        // unlink right from the leaf chain
+        left->next = right->next;
+        if (right->next)
+            right->next->prev = left;
+        else
+            tail_leaf = left;
+
+        remove_separator(parent, idx);
+        free_node(right);
     }
-};
 
-extern Arena *global_arena;
+    void merge_internals(InternalNode *parent, int idx, int depth)
+    {
+        top_cache_restructured(depth);
+        InternalNode *left = as_inner(parent->children[idx]);
+        InternalNode *right = as_inner(parent->children[idx + 1]);
+
+        // separator comes down between the two halves
+        left->keys[left->num_keys] = parent->keys[idx];
+        move_slots(left->keys + left->num_keys + 1, right->keys, right->num_keys);
+        move_slots(left->children + left->num_keys + 1, right->children, right->num_keys + 1);
+        left->num_keys += right->num_keys + 1;
+        reindex(left);
+
+        remove_separator(parent, idx);
+        free_node(right);
+    }
 
-template <typename KeyType, typename ValueType, int M = 256>
-class BPlusTree
-{
-private:
-    struct alignas(64) Node
+public:
+    // --- ITERATOR ---
+    // points at (leaf, slot). end() is (tail_leaf, tail_leaf->num_keys), so --end() works
+    class iterator
     {
-        bool is_leaf;
-        uint16_t num_keys; // Changed to uint16_t for packing, though alignment padding might negate this
-        KeyType keys[M];
-        
-        // Union for memory efficiency - Leaf uses values, Internal uses children
-        union {
-            ValueType values[M];      //  used if is_leaf = true
-            Node *children[M + 1]; //  used if is_leaf = false
-        };
+        friend class BPlusTree;
 
-        Node(bool leaf) : is_leaf(leaf), num_keys(0)
+        LeafNode *node;
+        int idx;
+
+        iterator(LeafNode *n, int i) : node(n), idx(i)
         {
-            // arrays are uninitialized for performance
+            skip_forward();
         }
 
-        static void *operator new(size_t size)
+        // move off the end of a leaf (or over empty leaves) onto the next entry
+        void skip_forward()
         {
-            if (!global_arena)
+            while (idx >= node->num_keys && node->next)
             {
-                throw std::runtime_error("Arena not initialized");
+                node = node->next;
+                idx = 0;
+                prefetch_leaf(node->next);
             }
-            return global_arena->allocate(size);
         }
-    };
 
-    Node *root;
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::pair<const KeyType, ValueType>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::pair<const KeyType &, ValueType &>;
 
-    // core of insertion algorithm
-    void insert_recursive(Node *node, KeyType key, ValueType value, Node *&new_sibling, KeyType &median)
-    {
-        // 1. find index to insert   --> though this is linear only but we can improve on this to use SIMD/ Binary search
-        int i = 0;
-        while (i < node->num_keys && key > node->keys[i])
+        iterator() : node(nullptr), idx(0) {}
+
+        const KeyType &key() const { return node->keys[idx]; }
+        ValueType &value() const { return node->values[idx]; }
+
+        std::pair<const KeyType &, ValueType &> operator*() const
         {
-            i++;
+            return {node->keys[idx], node->values[idx]};
         }
 
-        // 2. leaf logic
-        if (node->is_leaf)
+        iterator &operator++()
         {
-            // update existing value
-            if (i > 0 && node->keys[i - 1] == key)
-            {
-                node->values[i - 1] = value;
-                return;
-            }
-
-            // insert into arrays
-            // shift elements to right
-            for (int k = node->num_keys; k > i; k--) {
-                node->keys[k] = node->keys[k-1];
-                node->values[k] = node->values[k-1];
-            }
-            node->keys[i] = key;
-            node->values[i] = value;
-            node->num_keys++;
+            idx++;
+            skip_forward();
+            return *this;
+        }
 
-            // check Split
-            if (node->num_keys >= M)
+        iterator &operator--()
+        {
+            // step back over empty leaves; decrementing begin() is undefined like std::map
+            while (idx == 0 && node->prev)
             {
-                split_leaf(node, new_sibling, median);
+                node = node->prev;
+                idx = node->num_keys;
             }
-            return;
+            idx--;
+            return *this;
         }
 
-        // 3. rebalancing internal nodes
-        Node *child_sibling = nullptr;
-        KeyType child_median = KeyType();
-
-        insert_recursive(node->children[i], key, value, child_sibling, child_median);
+        iterator operator++(int)
+        {
+            iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
 
-        if (child_sibling != nullptr)
+        iterator operator--(int)
         {
-            // child split! ==> insert median and pointer into THIS node
-            // shift half keys to the right
-            for (int k = node->num_keys; k > i; k--) {
-                node->keys[k] = node->keys[k-1];
-            }
+            iterator tmp = *this;
+            --*this;
+            return tmp;
+        }
 
-            for (int k = node->num_keys + 1; k > i + 1; k--) {
-                node->children[k] = node->children[k-1];
-            }
+        bool operator==(const iterator &other) const { return node == other.node && idx == other.idx; }
+        bool operator!=(const iterator &other) const { return !(*this == other); }
+    };
 
-            node->keys[i] = child_median;
-            node->children[i + 1] = child_sibling;
-            node->num_keys++;
+    // half-open [first, last), usable in range-for
+    struct Range
+    {
+        iterator first;
+        iterator last;
 
-            if (node->num_keys >= M)
-            {
-                split_internal(node, new_sibling, median);
-            }
-        }
+        iterator begin() const { return first; }
+        iterator end() const { return last; }
+    };
+
+    // tree owns a private arena, freed with the tree
+    BPlusTree()
+        : owned_arena(new Arena(OWNED_ARENA_INITIAL_SIZE)), arena(owned_arena.get())
+    {
+        init_empty();
     }
 
-    // --- SPLITTING LOGIC ---
-    void split_leaf(Node *node, Node *&new_leaf, KeyType &median)
+    // nodes come from a caller-managed arena (per shard, thread_local, ...) that must outlive the tree.
+    // the tree never frees arena memory itself, reset() the arena once all its trees are gone
+    explicit BPlusTree(Arena &shared_arena)
+        : arena(&shared_arena)
     {
-        int mid = M / 2;
-        new_leaf = new Node(true);
+        init_empty();
+    }
 
-        // move right half
-        int num_moving = node->num_keys - mid;
-        for(int i=0; i<num_moving; i++) {
-            new_leaf->keys[i] = node->keys[mid + i];
-            new_leaf->values[i] = node->values[mid + i];
+    // nodes are raw arena memory, a copy would alias them
+    BPlusTree(const BPlusTree &) = delete;
+    BPlusTree &operator=(const BPlusTree &) = delete;
+
+    Arena &get_arena() const
+    {
+        return *arena;
+    }
+
+    // drops every entry. a private arena is reset in one go, with a shared arena the nodes
+    // go back to this tree's free lists instead
+    void clear()
+    {
+        if (owned_arena)
+        {
+            owned_arena->reset();
+            free_leaves = nullptr;
+            free_inners = nullptr;
+            live_leaves = 0;
+            live_inners = 0;
         }
-        new_leaf->num_keys = num_moving;
+        else
+        {
+            free_subtree(root);
+        }
+        init_empty();
+        refresh_top_cache();
+    }
 
-        // update the number of entries in old node
-        node->num_keys = mid;
+    // per-node footprint, each layout is sized for its own payload
+    static constexpr size_t leaf_node_bytes() { return sizeof(LeafNode); }
+    static constexpr size_t internal_node_bytes() { return sizeof(InternalNode); }
 
-        // leaf split copies up
-        median = new_leaf->keys[0];
+    // O(1), maintained incrementally
+    size_t size() const { return num_entries; }
+    bool empty() const { return num_entries == 0; }
+    int height() const { return num_levels; }
+    size_t leaf_count() const { return live_leaves; }
+    size_t internal_count() const { return live_inners; }
+
+    // walks every node (and the free lists): occupancy per level, fill histograms and bytes.
+    // O(nodes), meant for monitoring / tuning M, not for the hot path
+    BPlusTreeStats stats() const
+    {
+        BPlusTreeStats st;
+        st.keys = num_entries;
+        st.height = num_levels;
+        st.nodes_per_level.assign(num_levels, 0);
+
+        size_t leaf_keys = 0, inner_keys = 0;
+        collect_stats(root, 0, st, leaf_keys, inner_keys);
+
+        for (FreeNode *f = free_leaves; f; f = f->next)
+            st.free_list_bytes += sizeof(LeafNode);
+        for (FreeNode *f = free_inners; f; f = f->next)
+            st.free_list_bytes += sizeof(InternalNode);
+
+        st.leaf_fill_factor = (double)leaf_keys / ((double)st.leaf_nodes * (LeafM - 1));
+        if (st.internal_nodes)
+            st.internal_fill_factor = (double)inner_keys / ((double)st.internal_nodes * (InnerM - 1));
+
+        size_t leaf_slot = sizeof(KeyType) + sizeof(ValueType);
+        size_t inner_slot = sizeof(KeyType) + sizeof(Node *);
+        st.payload_bytes = st.keys * leaf_slot;
+        st.filter_bytes = filter.bytes();
+        st.top_cache_bytes = top_cache.bytes;
+        st.total_bytes = st.leaf_nodes * sizeof(LeafNode) + st.internal_nodes * sizeof(InternalNode) + st.free_list_bytes +
+                         st.filter_bytes + st.top_cache_bytes;
+        st.wasted_bytes = (st.leaf_nodes * LeafM - leaf_keys) * leaf_slot +
+                          (st.internal_nodes * InnerM - inner_keys) * inner_slot + st.free_list_bytes;
+        st.bytes_per_key = st.keys ? (double)st.total_bytes / st.keys : 0;
+        return st;
     }
 
-    void split_internal(Node *node, Node *&new_node, KeyType &median)
+    // true when built with -DBPT_STATS, op_counters() stays all zeros otherwise
+    static constexpr bool counters_enabled()
     {
-        int mid = M / 2;
-        new_node = new Node(false);
+#ifdef BPT_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
 
-        // the key at mid moves UP
-        median = node->keys[mid];
+    const BPlusTreeCounters &op_counters() const { return counters; }
+    void reset_op_counters() { counters = BPlusTreeCounters(); }
 
-        // move right half keys (excluding mid)
-        int num_keys_moving = node->num_keys - (mid + 1);
-        for(int i=0; i<num_keys_moving; i++) {
-            new_node->keys[i] = node->keys[mid + 1 + i];
-        }
-        new_node->num_keys = num_keys_moving;
+    iterator begin() const
+    {
+        return iterator(head_leaf, 0);
+    }
 
-        // move right half children
-        int num_children_moving = num_keys_moving + 1;
-        for(int i=0; i<num_children_moving; i++) {
-            new_node->children[i] = node->children[mid + 1 + i];
-        }
+    iterator end() const
+    {
+        return iterator(tail_leaf, tail_leaf->num_keys);
+    }
 
-        // update the entries in old node
-        node->num_keys = mid;
+    // first entry with key >= given key
+    iterator lower_bound(KeyType key) const
+    {
+        LeafNode *leaf = find_leaf(key);
+        int i = std::lower_bound(leaf->keys, leaf->keys + leaf->num_keys, key) - leaf->keys;
+        return iterator(leaf, i);
     }
 
-    void remove_recursive(Node *node, KeyType key)
+    // first entry with key > given key
+    iterator upper_bound(KeyType key) const
     {
-        int i = 0;
-        while (i < node->num_keys && key >= node->keys[i])
+        LeafNode *leaf = find_leaf(key);
+        int i = std::upper_bound(leaf->keys, leaf->keys + leaf->num_keys, key) - leaf->keys;
+        return iterator(leaf, i);
+    }
+
+    // all entries with lo <= key < hi
+    Range range(KeyType lo, KeyType hi) const
+    {
+        if (!(lo < hi))
         {
-            i++;
+            iterator it = lower_bound(lo);
+            return {it, it};
         }
+        return {lower_bound(lo), lower_bound(hi)};
+    }
 
-        if (node->is_leaf)
+    // --- RANGE SCAN ---
+    // calls fn(key, value) for every lo <= key < hi, walking the leaf chain
+    // directly instead of going through the iterator, returns number of entries visited
+    template <typename Func>
+    size_t scan(KeyType lo, KeyType hi, Func &&fn) const
+    {
+        LeafNode *leaf = find_leaf(lo);
+        int i = std::lower_bound(leaf->keys, leaf->keys + leaf->num_keys, lo) - leaf->keys;
+        size_t visited = 0;
+
+        while (leaf)
         {
-            // check exact match
-            for (int k = 0; k < node->num_keys; k++)
+            // next leaf is almost always needed, start pulling it in before we scan this one
+            prefetch_leaf(leaf->next);
+
+            const KeyType *keys = leaf->keys;
+            const ValueType *values = leaf->values;
+            int n = leaf->num_keys;
+
+            for (; i < n; i++)
             {
-                if (node->keys[k] == key)
+                if (!(keys[i] < hi))
                 {
-                    // shift to the left
-                    for(int j=k; j < node->num_keys - 1; j++) {
-                        node->keys[j] = node->keys[j+1];
-                        node->values[j] = node->values[j+1];
-                    }
-                    node->num_keys--;
-                    return;
+                    return visited;
                 }
+                fn(keys[i], values[i]);
+                visited++;
             }
-            return;
-        }
-
-        // internal balancing
-        remove_recursive(node->children[i], key);
-    }
 
-public:
-    BPlusTree()
-    {
-        root = new Node(true);
+            leaf = leaf->next;
+            i = 0;
+        }
+        return visited;
     }
 
     // --- SEARCH (Linear Scan) ---
     bool findLinear(KeyType key, ValueType &val_out)
     {
+        BPT_COUNT(lookups, 1);
+        if (!filter_may_contain(key))
+            return false;
         Node *curr = root;
         while (!curr->is_leaf)
         {
+            BPT_COUNT(lookup_nodes, 1);
+            InternalNode *inner = as_inner(curr);
             int i = 0;
             // linear Scan: find first key > input
-            while (i < curr->num_keys && key >= curr->keys[i])
+            while (i < inner->num_keys && key >= inner->keys[i])
             {
                 i++;
             }
-            curr = curr->children[i];
+            curr = inner->children[i];
         }
 
+        LeafNode *leaf = as_leaf(curr);
+        BPT_COUNT(lookup_nodes, 1);
         // search in leaf
-        for (int i = 0; i < curr->num_keys; i++)
+        for (int i = 0; i < leaf->num_keys; i++)
         {
-            if (curr->keys[i] == key)
+            if (leaf->keys[i] == key)
             {
-                val_out = curr->values[i];
+                val_out = leaf->values[i];
                 return true;
             }
         }
@@ -277,11 +1974,16 @@ public:
 
     bool findBinary(KeyType key, ValueType &val_out)
     {
+        BPT_COUNT(lookups, 1);
+        if (!filter_may_contain(key))
+            return false;
         Node *curr = root;
         while (!curr->is_leaf)
         {
+            BPT_COUNT(lookup_nodes, 1);
+            InternalNode *inner = as_inner(curr);
             // binary search
-            int hi = curr->num_keys - 1;
+            int hi = inner->num_keys - 1;
             int lo = 0;
             int i = hi;
             int mid = lo + (hi - lo) / 2;
@@ -290,7 +1992,7 @@ public:
             {
                 mid = lo + (hi - lo) / 2;
 
-                if (curr->keys[mid] <= key)
+                if (inner->keys[mid] <= key)
                 {
                     lo = mid + 1;
                 }
@@ -303,24 +2005,26 @@ public:
 
             if (i == hi)
             {
-                if (curr->keys[i] > key)
+                if (inner->keys[i] > key)
                 { // means left child contains the leaf
-                    curr = curr->children[i];
+                    curr = inner->children[i];
                 }
                 else
                 {
                     // or it's rght will
-                    curr = curr->children[i + 1];
+                    curr = inner->children[i + 1];
                 }
             }
             else
             {
-                curr = curr->children[i];
+                curr = inner->children[i];
             }
         }
 
+        LeafNode *leaf = as_leaf(curr);
+        BPT_COUNT(lookup_nodes, 1);
         // search in leaf
-        int hi = curr->num_keys - 1;
+        int hi = leaf->num_keys - 1;
         int lo = 0;
         int i = hi;
         int mid = lo + (hi - lo) / 2;
@@ -329,7 +2033,7 @@ public:
         {
             mid = lo + (hi - lo) / 2;
 
-            if (curr->keys[mid] < key)
+            if (leaf->keys[mid] < key)
             {
                 lo = mid + 1;
             }
@@ -340,130 +2044,416 @@ public:
             }
         }
 
-        if (i >= 0 && i < curr->num_keys && curr->keys[i] == key)
+        if (i >= 0 && i < leaf->num_keys && leaf->keys[i] == key)
         {
-            val_out = curr->values[i];
+            val_out = leaf->values[i];
             return true;
         }
         return false;
     }
 
-    // --- INSERTION ---
+    // --- BATCHED SEARCH ---
+    // lookups advanced together per level, must stay small enough that the cursors live in registers / L1
+    static constexpr size_t FIND_BATCH_GROUP = 16;
 
-    // SIMD Search - enabled only for int keys
-    template <typename K = KeyType>
-    typename std::enable_if<std::is_same<K, int>::value, bool>::type
-    findSIMD(KeyType key, ValueType &val_out)
+    // routes n keys through the tree a level at a time: every lookup in a group picks its child,
+    // prefetches it and moves on to the next lookup, so the misses of different descents overlap
+    // instead of each descent waiting on its own
+    void findBatch(const KeyType *keys, size_t n, ValueType *out, uint8_t *found)
     {
-        Node *curr = root;
+        const Kernels &kern = Search::active();
+        Node *cursor[FIND_BATCH_GROUP];
+        size_t slot[FIND_BATCH_GROUP]; // position in keys / out / found of each cursor
 
-        while (!curr->is_leaf)
+        size_t next = 0;
+        while (next < n)
         {
-            int i = 0;
-            int result_index = curr->num_keys; // default to "Rightmost Child" if no key is bigger
-
-            // 1. fill  the Search Key into all 8 lanes
-            __m256i target_key_vec = _mm256_set1_epi32(key);
-
-            // loop in chunks of 8
-            // Unrolling slightly? 
-            for (; i < curr->num_keys; i += 8)
+            // the next keys the filter lets through, the rejected ones are answered on the spot
+            size_t g = 0;
+            for (; next < n && g < FIND_BATCH_GROUP; next++)
             {
-                // Prefetch next chunk of keys
-                _mm_prefetch((const char*)&curr->keys[i + 8], _MM_HINT_T0);
-
-                // 2. load 8 keys from the node (unaligned load is safe ==> tells the cpu that the adrees might not be multiple of 32 so handle this)
-                // With alignas(64) on Node and Arena, keys should be aligned, we can try aligned load later or rely on HW
-                __m256i chunk_key_vec = _mm256_loadu_si256((__m256i *)&curr->keys[i]);
+                BPT_COUNT(lookups, 1);
+                if (filter_may_contain(keys[next]))
+                {
+                    slot[g++] = next;
+                }
+                else
+                {
+                    found[next] = 0;
+                }
+            }
+            if (g == 0)
+            {
+                continue;
+            }
 
-                // 3. compare node vector with search vector : is NodeKey > SearchKey?
-                __m256i cmp_vec = _mm256_cmpgt_epi32(chunk_key_vec, target_key_vec);
+            for (size_t j = 0; j < g; j++)
+            {
+                cursor[j] = top_cache_descend(kern, keys[slot[j]]);
+                prefetch_node(cursor[j]);
+            }
 
-                // 4. create result Bitmask
-                int mask = _mm256_movemask_ps(_mm256_castsi256_ps(cmp_vec));
+            // all leaves are at the same depth, so the whole group reaches them on the same level
+            while (!cursor[0]->is_leaf)
+            {
+                BPT_COUNT(lookup_nodes, g);
+                for (size_t j = 0; j < g; j++)
+                {
+                    InternalNode *inner = as_inner(cursor[j]);
+                    Node *next_node = inner->children[search_inner(kern, inner, keys[slot[j]])];
+                    prefetch_node(next_node);
+                    cursor[j] = next_node;
+                }
+            }
 
-                // 5. check the mask
-                if (__builtin_expect(mask != 0, 0))
+            BPT_COUNT(lookup_nodes, g);
+            for (size_t j = 0; j < g; j++)
+            {
+                LeafNode *leaf = as_leaf(cursor[j]);
+                int idx = search_leaf(kern, leaf, keys[slot[j]]);
+                found[slot[j]] = idx >= 0;
+                if (idx >= 0)
                 {
-                    int bit_pos = __builtin_ctz(mask);
-                    int found_idx = i + bit_pos;
-                    
-                    // ensure we don't pick a garbage key beyond num_keys
-                    if (found_idx < curr->num_keys) {
-                        result_index = found_idx;
-                        break; 
-                    }
+                    out[slot[j]] = leaf->values[idx];
                 }
             }
+        }
+    }
+
+    // --- STEPWISE LOOKUP ---
+    // findSIMD cut into one node per call, for callers that keep many lookups in flight on one
+    // thread (the coroutines in async_lookup.hpp, hand-written state machines): every
+    // lookup_step() searches one node and prefetches the child it picks, so the caller can run
+    // other lookups / work while that node comes in from memory
+    class LookupState
+    {
+        friend class BPlusTree;
+        Node *node = nullptr;
+        const Kernels *kern = nullptr; // resolved once per descent, like findSIMD
+    };
+
+    // starts at the root. false if the key filter already answered (key absent, no steps needed)
+    bool lookup_begin(KeyType key, LookupState &state)
+    {
+        BPT_COUNT(lookups, 1);
+        if (!filter_may_contain(key))
+            return false;
+        state.kern = &Search::active();
+        state.node = top_cache_descend(*state.kern, key);
+        return true;
+    }
+
+    // true: moved down to a child that is being prefetched, call again later. false: the leaf has
+    // been searched and found / val_out hold the result
+    bool lookup_step(KeyType key, LookupState &state, ValueType &val_out, bool &found)
+    {
+        BPT_COUNT(lookup_nodes, 1);
+        if (!state.node->is_leaf)
+        {
+            InternalNode *inner = as_inner(state.node);
+            Node *next_node = inner->children[search_inner(*state.kern, inner, key)];
+            prefetch_node(next_node);
+            state.node = next_node;
+            return true;
+        }
+
+        LeafNode *leaf = as_leaf(state.node);
+        int idx = search_leaf(*state.kern, leaf, key);
+        found = idx >= 0;
+        if (found)
+        {
+            val_out = leaf->values[idx];
+        }
+        return false;
+    }
+
+    // --- INSERTION ---
+
+    // SIMD Search - vector kernel picked per key type and resolved for the running CPU
+    // (active_simd_isa()), falls back to binary search inside the nodes when KeyType has none
+    // (see has_simd_search())
+    bool findSIMD(KeyType key, ValueType &val_out)
+    {
+        const Kernels &kern = Search::active();
+        BPT_COUNT(lookups, 1);
+        if (!filter_may_contain(key))
+            return false;
+        Node *curr = top_cache_descend(kern, key);
+
+        while (!curr->is_leaf)
+        {
+            BPT_COUNT(lookup_nodes, 1);
+            InternalNode *inner = as_inner(curr);
             
             // Prefetch the next node
-            // Note: curr->children is in the same union location.
-            // When we go deeper, we access children. 
             // We should prefetch the 'keys' of the next child, but we don't know the exact address offset without dereferencing logic.
             // Just prefetching the pointer target:
-            Node* next_node = curr->children[result_index];
-            _mm_prefetch((const char*)next_node, _MM_HINT_T0);
-            _mm_prefetch((const char*)((char*)next_node + 64), _MM_HINT_T0); // prefetch 2 cache lines of the next node
+            Node* next_node = inner->children[search_inner(kern, inner, key)];
+            prefetch_t0(next_node);
+            prefetch_t0((const char*)next_node + 64); // prefetch 2 cache lines of the next node
 
             curr = next_node;
         }
 
-        // --- Search in Leaf (SIMD) ---
-        __m256i target_vec = _mm256_set1_epi32(key);
-
-        for (int i = 0; i < curr->num_keys; i += 8)
+        LeafNode *leaf = as_leaf(curr);
+        BPT_COUNT(lookup_nodes, 1);
+        int idx = search_leaf(kern, leaf, key);
+        if (idx >= 0)
         {
-            // Prefetch next chunk
-             _mm_prefetch((const char*)&curr->keys[i + 8], _MM_HINT_T0);
-
-            __m256i chunk_vec = _mm256_loadu_si256((__m256i *)&curr->keys[i]);
-            __m256i eq_vec = _mm256_cmpeq_epi32(chunk_vec, target_vec);
-            int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq_vec));
+            val_out = leaf->values[idx];
+            return true;
+        }
+        return false;
+    }
 
-            if (__builtin_expect(mask != 0, 0))
-            {
-                int bit_pos = __builtin_ctz(mask);
-                int idx = i + bit_pos;
+    // Branchless Search - popcount of `node_key <= key` over the whole padded key range of every
+    // node, so the only branches left are the loop bounds and the final hit check. For keys
+    // without a sentinel this is a plain binary search
+    bool findBranchless(KeyType key, ValueType &val_out)
+    {
+        const Kernels &kern = Search::active();
+        BPT_COUNT(lookups, 1);
+        if (!filter_may_contain(key))
+            return false;
+        Node *curr = root;
 
-                if (idx < curr->num_keys)
-                {
-                    val_out = curr->values[idx];
-                    return true;
-                }
-            }
+        while (!curr->is_leaf)
+        {
+            BPT_COUNT(lookup_nodes, 1);
+            InternalNode *inner = as_inner(curr);
+            Node *next_node = inner->children[kern.upper_bound_branchless(inner->keys, inner->num_keys, InnerM, key)];
+            prefetch_t0(next_node);
+            prefetch_t0((const char *)next_node + 64);
+            curr = next_node;
         }
 
+        LeafNode *leaf = as_leaf(curr);
+        BPT_COUNT(lookup_nodes, 1);
+        // last key <= input is the only candidate
+        int idx = kern.upper_bound_branchless(leaf->keys, leaf->num_keys, LeafM, key) - 1;
+        if (idx >= 0 && leaf->keys[idx] == key)
+        {
+            val_out = leaf->values[idx];
+            return true;
+        }
         return false;
     }
 
+    static constexpr bool has_simd_search()
+    {
+        return Search::has_simd;
+    }
+
+    // true when Filter is not NoFilter: find* / findBatch reject absent keys before descending
+    static constexpr bool has_key_filter()
+    {
+        return KeyFilter::enabled;
+    }
+
+    // --- TOP-LEVELS CACHE ---
+    static constexpr size_t DEFAULT_TOP_CACHE_BYTES = 256 * 1024;
+
+    // keeps a compact copy of the upper internal levels (keys, counts and computed child positions,
+    // child pointers only on the last mirrored level) in its own huge-page arena. findSIMD, findBatch
+    // and lookup_begin route through it before touching a real node, so the levels every lookup
+    // crosses stay small and contiguous even when scans churn the cache. Levels are mirrored from
+    // the root down while they fit max_bytes (the default takes the top two levels of a 1M-key
+    // M = 256 tree). A split / merge right below the mirror re-copies one mirrored node, only
+    // splits / merges of mirrored nodes rebuild it, deeper ones don't touch it.
+    // Needs trivially copyable keys
+    void enable_top_cache(size_t max_bytes = DEFAULT_TOP_CACHE_BYTES)
+    {
+        static_assert(std::is_trivially_copyable<KeyType>::value, "the top-levels cache copies keys as bytes");
+        if (max_bytes == 0)
+        {
+            throw std::invalid_argument("enable_top_cache needs a non-zero byte budget");
+        }
+        if (!top_cache.arena)
+        {
+            // one 2 MB page holds the default budget
+            size_t initial = std::max<size_t>(2ULL * 1024 * 1024, max_bytes + 4096);
+            top_cache.arena.reset(new Arena(initial, Arena::UNLIMITED, Arena::HugePages::Transparent));
+        }
+        top_cache.max_bytes = max_bytes;
+        rebuild_top_cache();
+    }
 
-    template <typename K = KeyType>
-    typename std::enable_if<!std::is_same<K, int>::value, bool>::type
-    findSIMD(KeyType key, ValueType &val_out)
+    void disable_top_cache()
     {
-        return findBinary(key, val_out);
+        top_cache = TopCache();
     }
 
+    bool top_cache_enabled() const { return top_cache.max_bytes != 0; }
+    int top_cache_levels() const { return top_cache.levels; }
+    size_t top_cache_bytes() const { return top_cache.bytes; }
+
+    // inserts or overwrites. Slots are found with the same node search as findSIMD (so the layout
+    // index and the CPU's vector kernel), shifts are bulk moves
     void insert(KeyType key, ValueType value)
     {
-        Node *new_child = nullptr;
-        KeyType median = KeyType();
+        insert_with<InsertPath::Kernel>(key, value);
+    }
 
-        insert_recursive(root, key, value, new_child, median);
+    // same with a binary search in every node
+    void insertBinary(KeyType key, ValueType value)
+    {
+        insert_with<InsertPath::Binary>(key, value);
+    }
 
-        if (new_child != nullptr)
+    // linear scan and element-by-element shifts, the baseline the two above are measured against
+    void insertLinear(KeyType key, ValueType value)
+    {
+        insert_with<InsertPath::Linear>(key, value);
+    }
+
+    // inserts (or overwrites) a run of pairs sorted by strictly increasing key. Every node the run
+    // touches is visited once, top-down, instead of one root-to-leaf descent per key
+    // (BufferedBPlusTree flushes through this)
+    template <typename Iter>
+    void merge_sorted(Iter first, Iter last)
+    {
+        if (first == last)
         {
-            Node *new_root = new Node(false);
-            new_root->keys[0] = median;
+            return;
+        }
+        const Kernels &kern = Search::active();
+        SplitList splits;
+        merge_recursive(kern, root, 0, first, last, splits);
+
+        // the root split, possibly several times: grow new roots until one node is left on top
+        while (!splits.empty())
+        {
+            InternalNode *new_root = new_internal_node();
             new_root->children[0] = root;
-            new_root->children[1] = new_child;
-            new_root->num_keys = 1;
+            reindex(new_root);
             root = new_root;
+            num_levels++;
+            top_cache.dirty = true;
+
+            SplitList above;
+            add_separators(kern, new_root, 0, splits, above);
+            splits.swap(above);
+        }
+
+        for (; first != last; ++first)
+        {
+            filter_added(first->first);
+        }
+        refresh_top_cache();
+    }
+
+    // inserts (or overwrites) the pairs in [first, last). Input that isn't sorted by strictly
+    // increasing key is copied and sorted first (a later duplicate wins). Consecutive keys fill the
+    // current leaf through a cached root-to-leaf path that is only re-descended once a key passes
+    // the leaf's upper fence, and a node that fills up through appends at its end splits 90/10
+    // instead of in half, so ascending streams (log indexes) leave ~90% full nodes behind
+    template <typename Iter>
+    void insert_batch(Iter first, Iter last)
+    {
+        bool sorted = true;
+        for (Iter it = first, prev_it = first; it != last; prev_it = it, ++it)
+        {
+            if (it != first && !(prev_it->first < it->first))
+            {
+                sorted = false;
+                break;
+            }
+        }
+
+        if (!sorted)
+        {
+            std::vector<std::pair<KeyType, ValueType>> entries(first, last);
+            std::stable_sort(entries.begin(), entries.end(),
+                             [](const auto &a, const auto &b) { return a.first < b.first; });
+            // equal keys stay in input order, each overwrites the one before
+            insert_ascending(entries.begin(), entries.end());
+            return;
+        }
+        insert_ascending(first, last);
+    }
+
+    // --- BULK LOAD ---
+    // replaces the contents of the tree with the (key, value) pairs in [first, last).
+    // input sorted by strictly increasing key is used as is, anything else is copied and
+    // sorted first (a later duplicate wins, same as repeated insert calls).
+    // leaves are packed to fill_factor of their capacity, and every node is allocated
+    // back to back in the arena, leaves first and then one internal level at a time up to the root.
+    // nodes of the previous contents go to the free lists once the new tree is built.
+    template <typename Iter>
+    void bulk_load(Iter first, Iter last, double fill_factor = 1.0)
+    {
+        if (!(fill_factor > 0.0 && fill_factor <= 1.0))
+        {
+            throw std::invalid_argument("bulk_load fill_factor must be in (0, 1]");
+        }
+
+        // every node is replaced (an empty range too), the mirror must not outlive them
+        top_cache.dirty = true;
+        Node *old_root = root;
+
+        bool sorted = true;
+        size_t n = 0;
+        for (Iter it = first, prev_it = first; it != last; prev_it = it, ++it, ++n)
+        {
+            if (n > 0 && !(prev_it->first < it->first))
+            {
+                sorted = false;
+            }
         }
+
+        if (sorted)
+        {
+            build_bottom_up(first, n, fill_factor);
+            free_subtree(old_root);
+            if constexpr (KeyFilter::enabled)
+                rebuild_filter();
+            refresh_top_cache();
+            return;
+        }
+
+        std::vector<std::pair<KeyType, ValueType>> entries(first, last);
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const auto &a, const auto &b) { return a.first < b.first; });
+
+        // keep the last occurrence of each key
+        size_t out = 0;
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (i + 1 < entries.size() && !(entries[i].first < entries[i + 1].first))
+            {
+                continue;
+            }
+            entries[out++] = entries[i];
+        }
+        entries.resize(out);
+
+        build_bottom_up(entries.begin(), entries.size(), fill_factor);
+        free_subtree(old_root);
+        if constexpr (KeyFilter::enabled)
+            rebuild_filter();
+        refresh_top_cache();
     }
 
-    void remove(KeyType key)
+    // returns false if the key was not present
+    bool remove(KeyType key)
     {
-        remove_recursive(root, key);
+        if (!remove_recursive(Search::active(), root, key, 0))
+        {
+            return false;
+        }
+
+        // collapse the root once its last separator is gone
+        if (!root->is_leaf && root->num_keys == 0)
+        {
+            Node *old_root = root;
+            root = as_inner(old_root)->children[0];
+            free_node(old_root);
+            num_levels--;
+            top_cache.dirty = true;
+        }
+        num_entries--;
+        filter_removed();
+        refresh_top_cache(key);
+        return true;
     }
 };
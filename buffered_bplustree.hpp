@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "bplustree.hpp"
+
+// --- WRITE-BUFFERED TREE ---
+// inserts are appended to a small unsorted front buffer. Once BufferSize entries are waiting the
+// buffer is stable-sorted (the last write of a key wins) and merged into the tree with
+// merge_sorted(), which visits every affected node once instead of descending per key, so a
+// burst of inserts touches the upper levels once per flush. Reads scan the buffer (SIMD) before
+// the tree.
+//
+// pays off when a flush shares leaves (bursts of nearby keys, appends). Uniformly random keys over
+// a large tree hit one leaf each, so sorting costs about what the saved descents win back.
+//
+// iteration / range scans see only the tree: call flush() first
+template <typename KeyType, typename ValueType, int InnerM = 256, int LeafM = InnerM,
+          typename Layout = SortedLayout, int BufferSize = 1024>
+class BufferedBPlusTree
+{
+    static_assert(BufferSize >= 1, "BufferedBPlusTree needs room for at least one buffered key");
+
+public:
+    using Tree = BPlusTree<KeyType, ValueType, InnerM, LeafM, Layout>;
+
+private:
+    using Search = KeySearch<KeyType>;
+
+    Tree tree;
+
+    // entries[0..count) in arrival order, newer than whatever the tree holds for their keys
+    KeyType buffer_keys[BufferSize];
+    ValueType buffer_values[BufferSize];
+    int count = 0;
+
+    std::vector<std::pair<KeyType, ValueType>> sorted; // flush scratch, kept between flushes
+
+    // first slot >= from holding key, -1 if none
+    int buffer_find(KeyType key, int from = 0) const
+    {
+        int idx;
+        if constexpr (Search::has_simd)
+        {
+            idx = Search::active().find(buffer_keys + from, count - from, key);
+        }
+        else
+        {
+            idx = scalar_search::find(buffer_keys + from, count - from, key); // generic kernels assume sorted keys
+        }
+        return idx < 0 ? -1 : from + idx;
+    }
+
+    // newest slot holding key, -1 if none
+    int buffer_find_last(KeyType key) const
+    {
+        int idx = buffer_find(key);
+        for (int next = idx; next >= 0; next = buffer_find(key, idx + 1))
+        {
+            idx = next;
+        }
+        return idx;
+    }
+
+public:
+    BufferedBPlusTree() = default;
+
+    explicit BufferedBPlusTree(Arena &shared_arena) : tree(shared_arena) {}
+
+    BufferedBPlusTree(const BufferedBPlusTree &) = delete;
+    BufferedBPlusTree &operator=(const BufferedBPlusTree &) = delete;
+
+    void insert(KeyType key, ValueType value)
+    {
+        buffer_keys[count] = key;
+        buffer_values[count] = value;
+        if (++count == BufferSize)
+        {
+            flush();
+        }
+    }
+
+    // buffer first (it holds the newest value), then the tree
+    bool findSIMD(KeyType key, ValueType &val_out)
+    {
+        int idx = buffer_find_last(key);
+        if (idx >= 0)
+        {
+            val_out = buffer_values[idx];
+            return true;
+        }
+        return tree.findSIMD(key, val_out);
+    }
+
+    // returns false if the key was in neither the buffer nor the tree
+    bool remove(KeyType key)
+    {
+        int idx = buffer_find(key);
+        bool removed = idx >= 0;
+        if (removed)
+        {
+            // drop every pending write of key, keeping the arrival order of the rest
+            int kept = idx;
+            for (int i = idx + 1; i < count; i++)
+            {
+                if (!(buffer_keys[i] == key))
+                {
+                    buffer_keys[kept] = buffer_keys[i];
+                    buffer_values[kept] = std::move(buffer_values[i]);
+                    kept++;
+                }
+            }
+            count = kept;
+        }
+        return tree.remove(key) || removed;
+    }
+
+    // sorts the buffer and merges it into the tree
+    void flush()
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        sorted.clear();
+        for (int i = 0; i < count; i++)
+        {
+            sorted.emplace_back(buffer_keys[i], std::move(buffer_values[i]));
+        }
+        // stable: equal keys stay in arrival order, so the last of each run is the newest write
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const auto &a, const auto &b) { return a.first < b.first; });
+        size_t out = 0;
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            if (i + 1 < sorted.size() && !(sorted[i].first < sorted[i + 1].first))
+            {
+                continue;
+            }
+            if (out != i)
+            {
+                sorted[out] = std::move(sorted[i]);
+            }
+            out++;
+        }
+        sorted.resize(out);
+        tree.merge_sorted(sorted.begin(), sorted.end());
+        count = 0;
+    }
+
+    // pending entries, a key written twice counts twice
+    int buffered() const { return count; }
+
+    // the tree without the buffer (flush() first for a complete view)
+    Tree &get_tree() { return tree; }
+    const Tree &get_tree() const { return tree; }
+};
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "static_bplustree.hpp"
+
+// --- COMPRESSED (FROZEN) TREE ---
+// read-only snapshot for integer keys with frame-of-reference leaves. The sorted keys are cut
+// into blocks of one cache line each: a block stores its first key (the base) once and every
+// key as base + delta in 1, 2, 4 or 8 bytes, whichever width fits the most keys into the line
+// (64 / 32 / 16 / 8 keys). Dense keys (ids, timestamps) mostly land in 1 / 2-byte blocks, so a
+// line holds 2-8x the keys of a raw leaf.
+//
+// the bases go into a StaticBPlusTree, so a lookup is a predecessor search over the bases, then
+// one vector compare of the key's delta against the whole line (no decoding into a buffer).
+// values stay uncompressed, in key order.
+template <typename KeyType, typename ValueType>
+class CompressedStaticBPlusTree
+{
+    static_assert(std::is_integral<KeyType>::value && !std::is_same<KeyType, bool>::value,
+                  "CompressedStaticBPlusTree needs an integer key (deltas)");
+    static_assert(std::is_trivially_copyable<ValueType>::value,
+                  "CompressedStaticBPlusTree keeps values in raw arena memory");
+
+public:
+    static constexpr int BLOCK_BYTES = 64;
+
+private:
+    using DeltaType = typename std::make_unsigned<KeyType>::type;
+
+    struct BlockInfo
+    {
+        uint32_t first; // position of the block's first key = index into values[]
+        uint8_t width;  // bytes per delta
+        uint8_t count;
+    };
+
+    StaticBPlusTree<KeyType, BlockInfo> index; // block base -> block info
+
+    std::unique_ptr<Arena> arena;
+    const uint8_t *lines = nullptr; // BLOCK_BYTES per block, 64-byte aligned
+    const ValueType *values = nullptr;
+    size_t n = 0;
+    size_t num_blocks = 0;
+    size_t width_blocks[4] = {}; // blocks per delta width (1, 2, 4, 8 bytes)
+
+    static int width_slot(int width) { return width == 1 ? 0 : width == 2 ? 1 : width == 4 ? 2 : 3; }
+
+    // keys from keys[i] on that fit one block at `width` bytes per delta
+    static int block_reach(const std::vector<KeyType> &keys, size_t i, int width)
+    {
+        int cap = BLOCK_BYTES / width;
+        size_t end = std::min(keys.size(), i + cap);
+        if (width >= (int)sizeof(DeltaType))
+        {
+            return (int)(end - i);
+        }
+        DeltaType limit = (DeltaType)1 << (8 * width);
+        size_t j = i + 1;
+        while (j < end && (DeltaType)((DeltaType)keys[j] - (DeltaType)keys[i]) < limit)
+        {
+            j++;
+        }
+        return (int)(j - i);
+    }
+
+    static void store_delta(uint8_t *line, int width, int slot, DeltaType delta)
+    {
+        switch (width)
+        {
+        case 1: line[slot] = (uint8_t)delta; break;
+        case 2: { uint16_t d = (uint16_t)delta; std::memcpy(line + 2 * slot, &d, 2); break; }
+        case 4: { uint32_t d = (uint32_t)delta; std::memcpy(line + 4 * slot, &d, 4); break; }
+        default: { uint64_t d = (uint64_t)delta; std::memcpy(line + 8 * slot, &d, 8); break; }
+        }
+    }
+
+    // slot of delta in the first count deltas of a line, -1 if absent
+    static int line_find(const uint8_t *line, int width, int count, DeltaType delta)
+    {
+#if BPT_ARCH_X86
+        // SSE2 is baseline on x86-64: compare the whole line, movemask gives one bit per byte and
+        // a lane matched when all of its bytes did
+        __m128i target;
+        switch (width)
+        {
+        case 1: target = _mm_set1_epi8((char)delta); break;
+        case 2: target = _mm_set1_epi16((short)delta); break;
+        case 4: target = _mm_set1_epi32((int)delta); break;
+        default: target = _mm_set1_epi64x((long long)delta); break;
+        }
+        uint64_t mask = 0;
+        for (int i = 0; i < BLOCK_BYTES / 16; i++)
+        {
+            __m128i chunk = _mm_load_si128((const __m128i *)(line + 16 * i));
+            __m128i eq;
+            switch (width)
+            {
+            case 1: eq = _mm_cmpeq_epi8(chunk, target); break;
+            case 2: eq = _mm_cmpeq_epi16(chunk, target); break;
+            default: eq = _mm_cmpeq_epi32(chunk, target); break;
+            }
+            mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(eq) << (16 * i);
+        }
+        if (width == 8)
+        {
+            mask &= mask >> 4; // both 32-bit halves equal
+            mask &= 0x0F0F0F0F0F0F0F0FULL;
+        }
+        int valid_bytes = count * width;
+        if (valid_bytes < 64)
+        {
+            mask &= (1ULL << valid_bytes) - 1;
+        }
+        return mask ? __builtin_ctzll(mask) / width : -1;
+#else
+        for (int i = 0; i < count; i++)
+        {
+            DeltaType d;
+            switch (width)
+            {
+            case 1: d = line[i]; break;
+            case 2: { uint16_t v; std::memcpy(&v, line + 2 * i, 2); d = v; break; }
+            case 4: { uint32_t v; std::memcpy(&v, line + 4 * i, 4); d = v; break; }
+            default: { uint64_t v; std::memcpy(&v, line + 8 * i, 8); d = (DeltaType)v; break; }
+            }
+            if (d == delta)
+                return i;
+        }
+        return -1;
+#endif
+    }
+
+    // sorted entries cut into blocks, before anything is laid out
+    struct Encoded
+    {
+        std::vector<KeyType> keys;
+        std::vector<ValueType> values;
+        std::vector<std::pair<KeyType, BlockInfo>> blocks; // base -> info, in key order
+    };
+
+    template <typename Iter>
+    static Encoded encode(Iter first, Iter last)
+    {
+        Encoded enc;
+        for (; first != last; ++first)
+        {
+            auto &&entry = *first;
+            enc.keys.push_back(entry.first);
+            enc.values.push_back(entry.second);
+        }
+        size_t count = enc.keys.size();
+        if (count > UINT32_MAX)
+        {
+            throw std::length_error("CompressedStaticBPlusTree holds at most 2^32 - 1 keys");
+        }
+
+        // greedy cut: each block takes the width that fits the most keys (ties: narrower)
+        for (size_t i = 0; i < count;)
+        {
+            int best_width = 1, best_count = 0;
+            for (int width = 1; width <= (int)sizeof(KeyType); width *= 2)
+            {
+                int reach = block_reach(enc.keys, i, width);
+                if (reach > best_count)
+                {
+                    best_width = width;
+                    best_count = reach;
+                }
+            }
+            enc.blocks.push_back({enc.keys[i], BlockInfo{(uint32_t)i, (uint8_t)best_width, (uint8_t)best_count}});
+            i += best_count;
+        }
+        return enc;
+    }
+
+    CompressedStaticBPlusTree(Encoded &&enc, Arena::HugePages huge)
+        : index(enc.blocks.begin(), enc.blocks.end(), huge), n(enc.keys.size()), num_blocks(enc.blocks.size())
+    {
+        size_t line_bytes = num_blocks * BLOCK_BYTES;
+        size_t value_bytes = (n * sizeof(ValueType) + 63) & ~(size_t)63;
+        arena.reset(new Arena(line_bytes + value_bytes + 4096, Arena::UNLIMITED, huge));
+        uint8_t *line_data = static_cast<uint8_t *>(arena->allocate(std::max<size_t>(line_bytes, 64)));
+        ValueType *value_data = static_cast<ValueType *>(arena->allocate(std::max<size_t>(value_bytes, 64)));
+        std::memset(line_data, 0, line_bytes);
+
+        for (size_t b = 0; b < num_blocks; b++)
+        {
+            const BlockInfo &info = enc.blocks[b].second;
+            uint8_t *line = line_data + b * BLOCK_BYTES;
+            DeltaType base = (DeltaType)enc.keys[info.first];
+            for (int j = 0; j < info.count; j++)
+            {
+                store_delta(line, info.width, j, (DeltaType)((DeltaType)enc.keys[info.first + j] - base));
+            }
+            width_blocks[width_slot(info.width)]++;
+        }
+        std::copy(enc.values.begin(), enc.values.end(), value_data);
+        lines = line_data;
+        values = value_data;
+    }
+
+public:
+    // entries must be sorted by key without duplicates (e.g. a BPlusTree's own order)
+    template <typename Iter>
+    CompressedStaticBPlusTree(Iter first, Iter last, Arena::HugePages huge = Arena::HugePages::Off)
+        : CompressedStaticBPlusTree(encode(first, last), huge)
+    {
+    }
+
+    template <int InnerM, int LeafM, typename Layout, typename Filter>
+    explicit CompressedStaticBPlusTree(const BPlusTree<KeyType, ValueType, InnerM, LeafM, Layout, Filter> &tree,
+                                       Arena::HugePages huge = Arena::HugePages::Off)
+        : CompressedStaticBPlusTree(tree.begin(), tree.end(), huge)
+    {
+    }
+
+    CompressedStaticBPlusTree(CompressedStaticBPlusTree &&) = default;
+    CompressedStaticBPlusTree &operator=(CompressedStaticBPlusTree &&) = default;
+
+    // same signature as BPlusTree::findSIMD
+    bool findSIMD(KeyType key, ValueType &val_out) const
+    {
+        long b = index.predecessor(key);
+        if (b < 0)
+        {
+            return false;
+        }
+        const uint8_t *line = lines + (size_t)b * BLOCK_BYTES;
+        prefetch_t0(line);
+        const BlockInfo &info = index.value_at((size_t)b);
+        DeltaType delta = (DeltaType)((DeltaType)key - (DeltaType)index.key_at((size_t)b));
+        if (info.width < (int)sizeof(DeltaType) && (delta >> (8 * info.width)) != 0)
+        {
+            return false; // past the block's range
+        }
+        int idx = line_find(line, info.width, info.count, delta);
+        if (idx < 0)
+        {
+            return false;
+        }
+        val_out = values[info.first + idx];
+        return true;
+    }
+
+    size_t size() const { return n; }
+    size_t block_count() const { return num_blocks; }
+
+    // blocks that store their deltas in `width` (1, 2, 4 or 8) bytes
+    size_t blocks_with_width(int width) const { return width_blocks[width_slot(width)]; }
+
+    // everything needed to answer key lookups: delta lines + the base index (with block infos)
+    size_t key_bytes() const { return num_blocks * BLOCK_BYTES + index.memory_bytes(); }
+    size_t memory_bytes() const { return key_bytes() + ((n * sizeof(ValueType) + 63) & ~(size_t)63); }
+};
+
+// compressed read-only snapshot of a tree's current contents
+template <typename KeyType, typename ValueType, int InnerM, int LeafM, typename Layout, typename Filter>
+CompressedStaticBPlusTree<KeyType, ValueType> freeze_compressed(const BPlusTree<KeyType, ValueType, InnerM, LeafM, Layout, Filter> &tree,
+                                                                Arena::HugePages huge = Arena::HugePages::Off)
+{
+    return CompressedStaticBPlusTree<KeyType, ValueType>(tree, huge);
+}
@@ -0,0 +1,537 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include "epoch.hpp"
+#include "node_search.hpp"
+
+// --- CONCURRENT TREE (OPTIMISTIC LOCK COUPLING) ---
+// every node carries a version word: bit 0 = obsolete, bit 1 = locked, the rest counts writes.
+// readers never write shared memory: they remember a node's version, read it, and validate
+// the version afterwards (restarting from the root if a writer got in between). Writers upgrade
+// to an exclusive latch only on the nodes they modify, and full nodes are split eagerly on the
+// way down so a split never has to propagate upwards.
+//
+// nodes come from the heap instead of an Arena (arenas are single threaded); leaves unlinked by
+// remove() go through the EpochManager and are freed once no reader can still see them.
+// keys / values are copied out while racing with writers, so both must be trivially copyable.
+template <typename KeyType, typename ValueType, int InnerM = 256, int LeafM = InnerM>
+class ConcurrentBPlusTree
+{
+    static_assert(InnerM >= 3 && InnerM <= UINT16_MAX, "InnerM must fit the uint16_t key count");
+    static_assert(LeafM >= 2 && LeafM <= UINT16_MAX, "LeafM must fit the uint16_t key count");
+    static_assert(std::is_trivially_copyable<KeyType>::value && std::is_trivially_copyable<ValueType>::value,
+                  "optimistic readers copy keys and values while they may be written");
+
+    static void cpu_relax()
+    {
+#if BPT_ARCH_X86
+        __builtin_ia32_pause();
+#elif BPT_ARCH_NEON
+        asm volatile("yield");
+#endif
+    }
+
+    struct Node
+    {
+        static constexpr uint64_t OBSOLETE = 0b01;
+        static constexpr uint64_t LOCKED = 0b10;
+        static constexpr uint64_t VERSION_STEP = 0b100;
+
+        std::atomic<uint64_t> version{VERSION_STEP};
+        bool is_leaf;
+        uint16_t num_keys; // may be read torn by optimistic readers, always clamp before use
+
+        explicit Node(bool leaf) : is_leaf(leaf), num_keys(0) {}
+
+        // start an optimistic read, restart if a writer holds the node or it was unlinked
+        uint64_t read_lock_or_restart(bool &restart) const
+        {
+            uint64_t v = version.load(std::memory_order_acquire);
+            if (v & (LOCKED | OBSOLETE))
+            {
+                cpu_relax();
+                restart = true;
+            }
+            return v;
+        }
+
+        // everything read since read_lock_or_restart is consistent iff the version is unchanged
+        void read_unlock_or_restart(uint64_t v, bool &restart) const
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version.load(std::memory_order_relaxed) != v)
+            {
+                restart = true;
+            }
+        }
+
+        void check_or_restart(uint64_t v, bool &restart) const
+        {
+            read_unlock_or_restart(v, restart);
+        }
+
+        // exclusive latch, only if nobody wrote the node since version v was read
+        void upgrade_to_write_lock_or_restart(uint64_t &v, bool &restart)
+        {
+            if (!version.compare_exchange_strong(v, v + LOCKED, std::memory_order_acquire))
+            {
+                cpu_relax();
+                restart = true;
+            }
+        }
+
+        void write_unlock()
+        {
+            // clears LOCKED and carries into the version counter
+            version.fetch_add(LOCKED, std::memory_order_release);
+        }
+
+        void write_unlock_obsolete()
+        {
+            version.fetch_add(LOCKED | OBSOLETE, std::memory_order_release);
+        }
+    };
+
+    struct alignas(64) LeafNode : Node
+    {
+        KeyType keys[LeafM];
+        ValueType values[LeafM];
+
+        LeafNode() : Node(true) {}
+    };
+
+    struct alignas(64) InternalNode : Node
+    {
+        KeyType keys[InnerM];
+        Node *children[InnerM + 1];
+
+        InternalNode() : Node(false) {}
+    };
+
+    static LeafNode *as_leaf(Node *node) { return static_cast<LeafNode *>(node); }
+    static InternalNode *as_inner(Node *node) { return static_cast<InternalNode *>(node); }
+
+    using Search = KeySearch<KeyType>;
+    using Kernels = SearchKernels<KeyType>;
+
+    std::atomic<Node *> root;
+    mutable EpochManager epoch;
+
+    static void delete_node(void *p)
+    {
+        Node *node = static_cast<Node *>(p);
+        if (node->is_leaf)
+            delete as_leaf(node);
+        else
+            delete as_inner(node);
+    }
+
+    static void delete_subtree(Node *node)
+    {
+        if (!node->is_leaf)
+        {
+            InternalNode *inner = as_inner(node);
+            for (int i = 0; i <= inner->num_keys; i++)
+            {
+                delete_subtree(inner->children[i]);
+            }
+        }
+        delete_node(node);
+    }
+
+    static const Kernels &binary_kernels()
+    {
+        static const Kernels binary = {&scalar_search::binary_upper_bound<KeyType>, &scalar_search::binary_find<KeyType>,
+                                       &scalar_search::binary_upper_bound_branchless<KeyType>};
+        return binary;
+    }
+
+    // optimistic descent shared by the find* variants, kern decides how nodes are searched
+    bool lookup(const Kernels &kern, KeyType key, ValueType &val_out) const
+    {
+        EpochManager::Guard guard(epoch);
+    restart:
+        bool restart = false;
+        Node *node = root.load(std::memory_order_acquire);
+        uint64_t version = node->read_lock_or_restart(restart);
+        if (restart || node != root.load(std::memory_order_acquire))
+            goto restart;
+
+        {
+            Node *parent = nullptr;
+            uint64_t parent_version = 0;
+
+            while (!node->is_leaf)
+            {
+                InternalNode *inner = as_inner(node);
+                int n = std::min<int>(inner->num_keys, InnerM);
+                Node *child = inner->children[kern.upper_bound(inner->keys, n, key)];
+
+                if (parent)
+                {
+                    parent->read_unlock_or_restart(parent_version, restart);
+                    if (restart)
+                        goto restart;
+                }
+                // child must be validated before it is dereferenced
+                inner->check_or_restart(version, restart);
+                if (restart)
+                    goto restart;
+
+                parent = inner;
+                parent_version = version;
+                node = child;
+                prefetch_t0(node);
+                version = node->read_lock_or_restart(restart);
+                if (restart)
+                    goto restart;
+            }
+
+            LeafNode *leaf = as_leaf(node);
+            int n = std::min<int>(leaf->num_keys, LeafM);
+            int idx = kern.find(leaf->keys, n, key);
+            ValueType val{};
+            if (idx >= 0)
+                val = leaf->values[idx];
+
+            if (parent)
+            {
+                parent->read_unlock_or_restart(parent_version, restart);
+                if (restart)
+                    goto restart;
+            }
+            leaf->read_unlock_or_restart(version, restart);
+            if (restart)
+                goto restart;
+
+            if (idx >= 0)
+                val_out = val;
+            return idx >= 0;
+        }
+    }
+
+    // --- SPLITTING LOGIC (caller holds the node's and its parent's write latch) ---
+    static LeafNode *split_leaf(LeafNode *node, KeyType &median)
+    {
+        int mid = LeafM / 2;
+        LeafNode *new_leaf = new LeafNode();
+        int num_moving = node->num_keys - mid;
+        std::copy(node->keys + mid, node->keys + node->num_keys, new_leaf->keys);
+        std::copy(node->values + mid, node->values + node->num_keys, new_leaf->values);
+        new_leaf->num_keys = num_moving;
+        node->num_keys = mid;
+
+        // leaf split copies up
+        median = new_leaf->keys[0];
+        return new_leaf;
+    }
+
+    static InternalNode *split_internal(InternalNode *node, KeyType &median)
+    {
+        int mid = InnerM / 2;
+        InternalNode *new_node = new InternalNode();
+
+        // the key at mid moves UP
+        median = node->keys[mid];
+        int num_keys_moving = node->num_keys - (mid + 1);
+        std::copy(node->keys + mid + 1, node->keys + node->num_keys, new_node->keys);
+        std::copy(node->children + mid + 1, node->children + node->num_keys + 1, new_node->children);
+        new_node->num_keys = num_keys_moving;
+        node->num_keys = mid;
+        return new_node;
+    }
+
+    // parent is latched and has room (it was not full when we passed it)
+    static void insert_separator(InternalNode *parent, KeyType sep, Node *right)
+    {
+        int i = std::upper_bound(parent->keys, parent->keys + parent->num_keys, sep) - parent->keys;
+        std::copy_backward(parent->keys + i, parent->keys + parent->num_keys, parent->keys + parent->num_keys + 1);
+        std::copy_backward(parent->children + i + 1, parent->children + parent->num_keys + 1,
+                           parent->children + parent->num_keys + 2);
+        parent->keys[i] = sep;
+        parent->children[i + 1] = right;
+        parent->num_keys++;
+    }
+
+    // old root is latched, so nobody else can replace it concurrently
+    void make_root(KeyType sep, Node *left, Node *right)
+    {
+        InternalNode *new_root = new InternalNode();
+        new_root->keys[0] = sep;
+        new_root->children[0] = left;
+        new_root->children[1] = right;
+        new_root->num_keys = 1;
+        root.store(new_root, std::memory_order_release);
+    }
+
+    // latch parent (if any) then node, both against the versions read on the way down
+    static bool lock_pair(InternalNode *parent, uint64_t &parent_version, Node *node, uint64_t &version)
+    {
+        bool restart = false;
+        if (parent)
+        {
+            parent->upgrade_to_write_lock_or_restart(parent_version, restart);
+            if (restart)
+                return false;
+        }
+        node->upgrade_to_write_lock_or_restart(version, restart);
+        if (restart)
+        {
+            if (parent)
+                parent->write_unlock();
+            return false;
+        }
+        return true;
+    }
+
+public:
+    ConcurrentBPlusTree() : root(new LeafNode()) {}
+
+    ConcurrentBPlusTree(const ConcurrentBPlusTree &) = delete;
+    ConcurrentBPlusTree &operator=(const ConcurrentBPlusTree &) = delete;
+
+    // no other thread may be using the tree anymore
+    ~ConcurrentBPlusTree()
+    {
+        delete_subtree(root.load());
+    }
+
+    // SIMD Search - same dispatched kernels as BPlusTree::findSIMD, safe against concurrent writers
+    bool findSIMD(KeyType key, ValueType &val_out) const
+    {
+        return lookup(Search::active(), key, val_out);
+    }
+
+    bool findBinary(KeyType key, ValueType &val_out) const
+    {
+        return lookup(binary_kernels(), key, val_out);
+    }
+
+    // inserts or overwrites
+    void insert(KeyType key, ValueType value)
+    {
+        EpochManager::Guard guard(epoch);
+    restart:
+        bool restart = false;
+        Node *node = root.load(std::memory_order_acquire);
+        uint64_t version = node->read_lock_or_restart(restart);
+        if (restart || node != root.load(std::memory_order_acquire))
+            goto restart;
+
+        {
+            InternalNode *parent = nullptr;
+            uint64_t parent_version = 0;
+
+            while (!node->is_leaf)
+            {
+                InternalNode *inner = as_inner(node);
+
+                // full: split now, while the parent is known to have room
+                if (inner->num_keys >= InnerM)
+                {
+                    if (!lock_pair(parent, parent_version, inner, version))
+                        goto restart;
+                    if (!parent && node != root.load(std::memory_order_acquire))
+                    {
+                        // someone grew a new root above us
+                        inner->write_unlock();
+                        goto restart;
+                    }
+                    KeyType median;
+                    InternalNode *sibling = split_internal(inner, median);
+                    if (parent)
+                        insert_separator(parent, median, sibling);
+                    else
+                        make_root(median, inner, sibling);
+                    inner->write_unlock();
+                    if (parent)
+                        parent->write_unlock();
+                    goto restart;
+                }
+
+                if (parent)
+                {
+                    parent->read_unlock_or_restart(parent_version, restart);
+                    if (restart)
+                        goto restart;
+                }
+
+                int n = std::min<int>(inner->num_keys, InnerM);
+                Node *child = inner->children[std::upper_bound(inner->keys, inner->keys + n, key) - inner->keys];
+                inner->check_or_restart(version, restart);
+                if (restart)
+                    goto restart;
+
+                parent = inner;
+                parent_version = version;
+                node = child;
+                version = node->read_lock_or_restart(restart);
+                if (restart)
+                    goto restart;
+            }
+
+            LeafNode *leaf = as_leaf(node);
+            if (leaf->num_keys >= LeafM)
+            {
+                if (!lock_pair(parent, parent_version, leaf, version))
+                    goto restart;
+                if (!parent && node != root.load(std::memory_order_acquire))
+                {
+                    leaf->write_unlock();
+                    goto restart;
+                }
+                KeyType median;
+                LeafNode *sibling = split_leaf(leaf, median);
+                if (parent)
+                    insert_separator(parent, median, sibling);
+                else
+                    make_root(median, leaf, sibling);
+                leaf->write_unlock();
+                if (parent)
+                    parent->write_unlock();
+                goto restart;
+            }
+
+            leaf->upgrade_to_write_lock_or_restart(version, restart);
+            if (restart)
+                goto restart;
+            if (parent)
+            {
+                // leaf may have been moved under a different parent by a split in between
+                parent->read_unlock_or_restart(parent_version, restart);
+                if (restart)
+                {
+                    leaf->write_unlock();
+                    goto restart;
+                }
+            }
+
+            // first key >= input
+            int i = std::lower_bound(leaf->keys, leaf->keys + leaf->num_keys, key) - leaf->keys;
+            if (i < leaf->num_keys && leaf->keys[i] == key)
+            {
+                leaf->values[i] = value;
+            }
+            else
+            {
+                std::copy_backward(leaf->keys + i, leaf->keys + leaf->num_keys, leaf->keys + leaf->num_keys + 1);
+                std::copy_backward(leaf->values + i, leaf->values + leaf->num_keys, leaf->values + leaf->num_keys + 1);
+                leaf->keys[i] = key;
+                leaf->values[i] = value;
+                leaf->num_keys++;
+            }
+            leaf->write_unlock();
+        }
+    }
+
+    // leaves are not rebalanced; a leaf that runs empty is unlinked from its parent (when the
+    // parent keeps at least one other child) and retired through the epoch manager
+    bool remove(KeyType key)
+    {
+        EpochManager::Guard guard(epoch);
+    restart:
+        bool restart = false;
+        Node *node = root.load(std::memory_order_acquire);
+        uint64_t version = node->read_lock_or_restart(restart);
+        if (restart || node != root.load(std::memory_order_acquire))
+            goto restart;
+
+        {
+            InternalNode *parent = nullptr;
+            uint64_t parent_version = 0;
+            int child_pos = 0;
+
+            while (!node->is_leaf)
+            {
+                InternalNode *inner = as_inner(node);
+                if (parent)
+                {
+                    parent->read_unlock_or_restart(parent_version, restart);
+                    if (restart)
+                        goto restart;
+                }
+
+                int n = std::min<int>(inner->num_keys, InnerM);
+                int pos = std::upper_bound(inner->keys, inner->keys + n, key) - inner->keys;
+                Node *child = inner->children[pos];
+                inner->check_or_restart(version, restart);
+                if (restart)
+                    goto restart;
+
+                parent = inner;
+                parent_version = version;
+                child_pos = pos;
+                node = child;
+                version = node->read_lock_or_restart(restart);
+                if (restart)
+                    goto restart;
+            }
+
+            LeafNode *leaf = as_leaf(node);
+            int n = std::min<int>(leaf->num_keys, LeafM);
+            int idx = std::lower_bound(leaf->keys, leaf->keys + n, key) - leaf->keys;
+            bool present = idx < n && leaf->keys[idx] == key;
+            leaf->read_unlock_or_restart(version, restart);
+            if (restart)
+                goto restart;
+            if (!present)
+            {
+                return false;
+            }
+
+            // the last key of a leaf whose parent has other children: unlink the whole leaf
+            bool unlink = n == 1 && parent && parent->num_keys > 0;
+            if (unlink)
+            {
+                if (!lock_pair(parent, parent_version, leaf, version))
+                    goto restart;
+            }
+            else
+            {
+                leaf->upgrade_to_write_lock_or_restart(version, restart);
+                if (restart)
+                    goto restart;
+                if (parent)
+                {
+                    parent->read_unlock_or_restart(parent_version, restart);
+                    if (restart)
+                    {
+                        leaf->write_unlock();
+                        goto restart;
+                    }
+                }
+            }
+
+            std::copy(leaf->keys + idx + 1, leaf->keys + leaf->num_keys, leaf->keys + idx);
+            std::copy(leaf->values + idx + 1, leaf->values + leaf->num_keys, leaf->values + idx);
+            leaf->num_keys--;
+
+            if (!unlink)
+            {
+                leaf->write_unlock();
+                return true;
+            }
+
+            // drop children[child_pos] and the separator next to it
+            int sep = child_pos > 0 ? child_pos - 1 : 0;
+            std::copy(parent->keys + sep + 1, parent->keys + parent->num_keys, parent->keys + sep);
+            std::copy(parent->children + child_pos + 1, parent->children + parent->num_keys + 1,
+                      parent->children + child_pos);
+            parent->num_keys--;
+
+            leaf->write_unlock_obsolete();
+            parent->write_unlock();
+            epoch.retire(leaf, &delete_node);
+            return true;
+        }
+    }
+
+    static constexpr bool has_simd_search()
+    {
+        return Search::has_simd;
+    }
+};
@@ -0,0 +1,533 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "epoch.hpp"
+#include "node_search.hpp"
+
+// --- COPY-ON-WRITE TREE (PATH COPYING) ---
+// published nodes are never written again. A writer copies the root-to-leaf path it changes,
+// builds split nodes off to the side and publishes the new version (root + size) with one atomic
+// store; the replaced path is retired through the EpochManager. Readers load the version once
+// and descend with plain loads: no latches, versions or restarts, only the epoch announcement
+// that keeps the nodes they may still see alive.
+//
+// writers are serialized by a mutex and pay for a path copy per update, so this is for read
+// mostly data. update() applies a whole batch as one version: nodes copied earlier in the batch
+// are still private and are changed in place, so the copy cost is per touched node, not per key.
+//
+// a Snapshot pins one version (point-in-time reads / scans). It holds an epoch guard, so use it
+// on the thread that took it and keep it short, nothing retired after it can be freed meanwhile.
+// there is no leaf chain (it would have to be copied too), scans walk down from the root.
+template <typename KeyType, typename ValueType, int InnerM = 256, int LeafM = InnerM>
+class CowBPlusTree
+{
+    static_assert(InnerM >= 3 && InnerM <= UINT16_MAX, "InnerM must fit the uint16_t key count");
+    static_assert(LeafM >= 2 && LeafM <= UINT16_MAX, "LeafM must fit the uint16_t key count");
+
+    struct Node
+    {
+        bool is_leaf;
+        uint16_t num_keys;
+        uint64_t txn; // update that created the node, private to that update until it commits
+
+        Node(bool leaf, uint64_t t) : is_leaf(leaf), num_keys(0), txn(t) {}
+    };
+
+    struct alignas(64) LeafNode : Node
+    {
+        KeyType keys[LeafM];
+        ValueType values[LeafM];
+
+        explicit LeafNode(uint64_t t) : Node(true, t) {}
+    };
+
+    struct alignas(64) InternalNode : Node
+    {
+        KeyType keys[InnerM];
+        Node *children[InnerM + 1];
+
+        explicit InternalNode(uint64_t t) : Node(false, t) {}
+    };
+
+    // what readers load: the root and the entry count that go with it
+    struct Version
+    {
+        Node *root;
+        size_t size;
+        int height;
+    };
+
+    static LeafNode *as_leaf(Node *node) { return static_cast<LeafNode *>(node); }
+    static InternalNode *as_inner(Node *node) { return static_cast<InternalNode *>(node); }
+    static const LeafNode *as_leaf(const Node *node) { return static_cast<const LeafNode *>(node); }
+    static const InternalNode *as_inner(const Node *node) { return static_cast<const InternalNode *>(node); }
+
+    using Search = KeySearch<KeyType>;
+    using Kernels = SearchKernels<KeyType>;
+
+    mutable EpochManager epoch;
+    std::atomic<const Version *> current;
+    std::mutex writer;
+
+    // --- WRITER STATE (under `writer`) ---
+    uint64_t txn = 0;
+    Node *work_root = nullptr;
+    size_t work_size = 0;
+    int work_height = 1;
+    std::vector<Node *> replaced; // published nodes the pending version no longer uses
+
+    static void delete_node(void *p)
+    {
+        Node *node = static_cast<Node *>(p);
+        if (node->is_leaf)
+            delete as_leaf(node);
+        else
+            delete as_inner(node);
+    }
+
+    static void delete_version(void *p)
+    {
+        delete static_cast<const Version *>(p);
+    }
+
+    static void delete_subtree(Node *node)
+    {
+        if (!node->is_leaf)
+        {
+            InternalNode *inner = as_inner(node);
+            for (int i = 0; i <= inner->num_keys; i++)
+            {
+                delete_subtree(inner->children[i]);
+            }
+        }
+        delete_node(node);
+    }
+
+    static bool lookup(const Node *node, KeyType key, ValueType &val_out)
+    {
+        const Kernels &kern = Search::active();
+        while (!node->is_leaf)
+        {
+            const InternalNode *inner = as_inner(node);
+            node = inner->children[kern.upper_bound(inner->keys, inner->num_keys, key)];
+            prefetch_t0(node);
+            prefetch_t0((const char *)node + 64);
+        }
+        const LeafNode *leaf = as_leaf(node);
+        int idx = kern.find(leaf->keys, leaf->num_keys, key);
+        if (idx >= 0)
+        {
+            val_out = leaf->values[idx];
+            return true;
+        }
+        return false;
+    }
+
+    template <typename Func>
+    static size_t scan_subtree(const Node *node, KeyType lo, KeyType hi, Func &fn)
+    {
+        if (node->is_leaf)
+        {
+            const LeafNode *leaf = as_leaf(node);
+            int i = std::lower_bound(leaf->keys, leaf->keys + leaf->num_keys, lo) - leaf->keys;
+            size_t visited = 0;
+            for (; i < leaf->num_keys && leaf->keys[i] < hi; i++, visited++)
+            {
+                fn(leaf->keys[i], leaf->values[i]);
+            }
+            return visited;
+        }
+        const InternalNode *inner = as_inner(node);
+        // children[c] holds [keys[c - 1], keys[c])
+        int c = std::upper_bound(inner->keys, inner->keys + inner->num_keys, lo) - inner->keys;
+        size_t visited = 0;
+        for (; c <= inner->num_keys; c++)
+        {
+            if (c > 0 && !(inner->keys[c - 1] < hi))
+                break;
+            visited += scan_subtree(inner->children[c], lo, hi, fn);
+        }
+        return visited;
+    }
+
+    // --- PATH COPYING ---
+    // the node to change in this update: itself if the update created it, else a private copy
+    // (the original goes on the retire list once the update commits)
+    LeafNode *writable(LeafNode *leaf)
+    {
+        if (leaf->txn == txn)
+            return leaf;
+        LeafNode *copy = new LeafNode(txn);
+        copy->num_keys = leaf->num_keys;
+        std::copy(leaf->keys, leaf->keys + leaf->num_keys, copy->keys);
+        std::copy(leaf->values, leaf->values + leaf->num_keys, copy->values);
+        replaced.push_back(leaf);
+        return copy;
+    }
+
+    InternalNode *writable(InternalNode *inner)
+    {
+        if (inner->txn == txn)
+            return inner;
+        InternalNode *copy = new InternalNode(txn);
+        copy->num_keys = inner->num_keys;
+        std::copy(inner->keys, inner->keys + inner->num_keys, copy->keys);
+        std::copy(inner->children, inner->children + inner->num_keys + 1, copy->children);
+        replaced.push_back(inner);
+        return copy;
+    }
+
+    // a node this update dropped: never seen by readers if private, else retired at commit
+    void drop(Node *node)
+    {
+        if (node->txn == txn)
+            delete_node(node);
+        else
+            replaced.push_back(node);
+    }
+
+    // a full, private node split in half, the upper half goes into a new private node
+    LeafNode *split_leaf(LeafNode *node, KeyType &median)
+    {
+        int mid = LeafM / 2;
+        LeafNode *right = new LeafNode(txn);
+        right->num_keys = node->num_keys - mid;
+        std::copy(node->keys + mid, node->keys + node->num_keys, right->keys);
+        std::copy(node->values + mid, node->values + node->num_keys, right->values);
+        node->num_keys = mid;
+        median = right->keys[0];
+        return right;
+    }
+
+    InternalNode *split_internal(InternalNode *node, KeyType &median)
+    {
+        int mid = InnerM / 2;
+        InternalNode *right = new InternalNode(txn);
+        median = node->keys[mid];
+        right->num_keys = node->num_keys - (mid + 1);
+        std::copy(node->keys + mid + 1, node->keys + node->num_keys, right->keys);
+        std::copy(node->children + mid + 1, node->children + node->num_keys + 1, right->children);
+        node->num_keys = mid;
+        return right;
+    }
+
+    // returns the (private) replacement for node; split_right != nullptr if it split at median
+    Node *insert_recursive(Node *node, KeyType key, const ValueType &value, KeyType &median, Node *&split_right)
+    {
+        split_right = nullptr;
+        if (node->is_leaf)
+        {
+            LeafNode *leaf = as_leaf(node);
+            int i = std::lower_bound(leaf->keys, leaf->keys + leaf->num_keys, key) - leaf->keys;
+            if (i < leaf->num_keys && leaf->keys[i] == key)
+            {
+                leaf = writable(leaf);
+                leaf->values[i] = value;
+                return leaf;
+            }
+            leaf = writable(leaf);
+            std::copy_backward(leaf->keys + i, leaf->keys + leaf->num_keys, leaf->keys + leaf->num_keys + 1);
+            std::copy_backward(leaf->values + i, leaf->values + leaf->num_keys, leaf->values + leaf->num_keys + 1);
+            leaf->keys[i] = key;
+            leaf->values[i] = value;
+            leaf->num_keys++;
+            work_size++;
+            if (leaf->num_keys == LeafM)
+            {
+                split_right = split_leaf(leaf, median);
+            }
+            return leaf;
+        }
+
+        InternalNode *inner = as_inner(node);
+        int c = std::upper_bound(inner->keys, inner->keys + inner->num_keys, key) - inner->keys;
+        KeyType child_median;
+        Node *child_right;
+        Node *child = insert_recursive(inner->children[c], key, value, child_median, child_right);
+        if (child == inner->children[c] && !child_right)
+        {
+            return inner; // changed in place, the path above is already private
+        }
+
+        inner = writable(inner);
+        inner->children[c] = child;
+        if (child_right)
+        {
+            std::copy_backward(inner->keys + c, inner->keys + inner->num_keys, inner->keys + inner->num_keys + 1);
+            std::copy_backward(inner->children + c + 1, inner->children + inner->num_keys + 1,
+                               inner->children + inner->num_keys + 2);
+            inner->keys[c] = child_median;
+            inner->children[c + 1] = child_right;
+            inner->num_keys++;
+            if (inner->num_keys == InnerM)
+            {
+                split_right = split_internal(inner, median);
+            }
+        }
+        return inner;
+    }
+
+    // returns the replacement for node, nullptr if node ran empty and should be dropped
+    Node *remove_recursive(Node *node, KeyType key, bool &removed)
+    {
+        if (node->is_leaf)
+        {
+            LeafNode *leaf = as_leaf(node);
+            int i = std::lower_bound(leaf->keys, leaf->keys + leaf->num_keys, key) - leaf->keys;
+            if (i == leaf->num_keys || !(leaf->keys[i] == key))
+            {
+                return leaf;
+            }
+            removed = true;
+            work_size--;
+            if (leaf->num_keys == 1)
+            {
+                drop(leaf);
+                return nullptr;
+            }
+            leaf = writable(leaf);
+            std::copy(leaf->keys + i + 1, leaf->keys + leaf->num_keys, leaf->keys + i);
+            std::copy(leaf->values + i + 1, leaf->values + leaf->num_keys, leaf->values + i);
+            leaf->num_keys--;
+            return leaf;
+        }
+
+        InternalNode *inner = as_inner(node);
+        int c = std::upper_bound(inner->keys, inner->keys + inner->num_keys, key) - inner->keys;
+        Node *child = remove_recursive(inner->children[c], key, removed);
+        if (child == inner->children[c])
+        {
+            return inner;
+        }
+        if (child)
+        {
+            inner = writable(inner);
+            inner->children[c] = child;
+            return inner;
+        }
+
+        // child ran empty: drop it with the separator next to it (no rebalancing)
+        if (inner->num_keys == 0)
+        {
+            drop(inner);
+            return nullptr;
+        }
+        inner = writable(inner);
+        int sep = c > 0 ? c - 1 : 0;
+        std::copy(inner->keys + sep + 1, inner->keys + inner->num_keys, inner->keys + sep);
+        std::copy(inner->children + c + 1, inner->children + inner->num_keys + 1, inner->children + c);
+        inner->num_keys--;
+        return inner;
+    }
+
+    void begin_update()
+    {
+        const Version *v = current.load(std::memory_order_relaxed); // only writers replace it
+        txn++;
+        work_root = v->root;
+        work_size = v->size;
+        work_height = v->height;
+        replaced.clear();
+    }
+
+    void do_insert(KeyType key, const ValueType &value)
+    {
+        KeyType median;
+        Node *right;
+        work_root = insert_recursive(work_root, key, value, median, right);
+        if (right)
+        {
+            InternalNode *new_root = new InternalNode(txn);
+            new_root->keys[0] = median;
+            new_root->children[0] = work_root;
+            new_root->children[1] = right;
+            new_root->num_keys = 1;
+            work_root = new_root;
+            work_height++;
+        }
+    }
+
+    bool do_remove(KeyType key)
+    {
+        bool removed = false;
+        Node *root = remove_recursive(work_root, key, removed);
+        if (!root)
+        {
+            root = new LeafNode(txn);
+            work_height = 1;
+        }
+        // a root with a single child steps down
+        while (!root->is_leaf && root->num_keys == 0)
+        {
+            Node *child = as_inner(root)->children[0];
+            drop(root);
+            root = child;
+            work_height--;
+        }
+        work_root = root;
+        return removed;
+    }
+
+    // frees what a failed update built (private nodes only hang off private nodes)
+    void discard_private(Node *node)
+    {
+        if (node->txn != txn)
+            return;
+        if (!node->is_leaf)
+        {
+            InternalNode *inner = as_inner(node);
+            for (int i = 0; i <= inner->num_keys; i++)
+            {
+                discard_private(inner->children[i]);
+            }
+        }
+        delete_node(node);
+    }
+
+    // publish the pending version, then hand what it replaced to the epoch manager
+    void commit()
+    {
+        const Version *old = current.load(std::memory_order_relaxed);
+        if (work_root == old->root)
+        {
+            return; // nothing changed
+        }
+        const Version *next = new Version{work_root, work_size, work_height};
+        current.store(next, std::memory_order_release);
+
+        epoch.retire(const_cast<Version *>(old), &delete_version);
+        for (Node *node : replaced)
+        {
+            epoch.retire(node, &delete_node);
+        }
+        replaced.clear();
+    }
+
+public:
+    CowBPlusTree() : current(new Version{new LeafNode(0), 0, 1}) {}
+
+    CowBPlusTree(const CowBPlusTree &) = delete;
+    CowBPlusTree &operator=(const CowBPlusTree &) = delete;
+
+    // no other thread may be using the tree anymore
+    ~CowBPlusTree()
+    {
+        const Version *v = current.load();
+        delete_subtree(v->root);
+        delete v;
+    }
+
+    // --- READERS (no synchronization beyond the epoch guard) ---
+    bool findSIMD(KeyType key, ValueType &val_out) const
+    {
+        EpochManager::Guard guard(epoch);
+        return lookup(current.load(std::memory_order_acquire)->root, key, val_out);
+    }
+
+    size_t size() const
+    {
+        EpochManager::Guard guard(epoch);
+        return current.load(std::memory_order_acquire)->size;
+    }
+
+    int height() const
+    {
+        EpochManager::Guard guard(epoch);
+        return current.load(std::memory_order_acquire)->height;
+    }
+
+    // one version of the tree, fixed for the snapshot's lifetime
+    class Snapshot
+    {
+        EpochManager::Guard guard; // first: pinned before the version is loaded
+        const Version *version;
+
+    public:
+        explicit Snapshot(const CowBPlusTree &tree)
+            : guard(tree.epoch), version(tree.current.load(std::memory_order_acquire))
+        {
+        }
+
+        Snapshot(const Snapshot &) = delete;
+        Snapshot &operator=(const Snapshot &) = delete;
+
+        bool findSIMD(KeyType key, ValueType &val_out) const { return lookup(version->root, key, val_out); }
+
+        // calls fn(key, value) for every lo <= key < hi in key order, returns how many
+        template <typename Func>
+        size_t scan(KeyType lo, KeyType hi, Func &&fn) const
+        {
+            return scan_subtree(version->root, lo, hi, fn);
+        }
+
+        size_t size() const { return version->size; }
+        int height() const { return version->height; }
+    };
+
+    Snapshot snapshot() const { return Snapshot(*this); }
+
+    // --- WRITERS (serialized, each call publishes one version) ---
+    // inserts or overwrites
+    void insert(KeyType key, ValueType value)
+    {
+        std::lock_guard<std::mutex> lock(writer);
+        begin_update();
+        do_insert(key, value);
+        commit();
+    }
+
+    // leaves are not rebalanced, a leaf that runs empty is dropped from its parent
+    bool remove(KeyType key)
+    {
+        std::lock_guard<std::mutex> lock(writer);
+        begin_update();
+        bool removed = do_remove(key);
+        commit();
+        return removed;
+    }
+
+    // the writes of one update() call, published together when fn returns
+    class Batch
+    {
+        CowBPlusTree &tree;
+        explicit Batch(CowBPlusTree &t) : tree(t) {}
+        friend class CowBPlusTree;
+
+    public:
+        void insert(KeyType key, ValueType value) { tree.do_insert(key, value); }
+        bool remove(KeyType key) { return tree.do_remove(key); }
+    };
+
+    // fn(Batch &) runs under the writer lock, readers see either none or all of its writes
+    // (if fn throws, none)
+    template <typename Func>
+    void update(Func &&fn)
+    {
+        std::lock_guard<std::mutex> lock(writer);
+        begin_update();
+        Batch batch(*this);
+        try
+        {
+            fn(batch);
+        }
+        catch (...)
+        {
+            // nothing was published, readers never saw the private nodes
+            discard_private(work_root);
+            replaced.clear();
+            throw;
+        }
+        commit();
+    }
+
+    static constexpr bool has_simd_search()
+    {
+        return Search::has_simd;
+    }
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// --- EPOCH-BASED RECLAMATION ---
+// readers announce the global epoch they started in, writers retire unlinked memory tagged with
+// the epoch it was retired in. Memory is freed once every thread still inside a Guard started
+// after that epoch, so nobody can hold a pointer to it anymore.
+//
+// threads claim a slot on first use (up to MAX_THREADS per manager). A slot stays claimed when
+// its thread exits; whatever it had retired is freed when the manager is destroyed.
+class EpochManager
+{
+public:
+    static constexpr int MAX_THREADS = 256;
+    static constexpr size_t COLLECT_THRESHOLD = 64; // retired entries per thread before a collect
+
+private:
+    static constexpr uint64_t INACTIVE = UINT64_MAX;
+
+    struct Retired
+    {
+        void *ptr;
+        void (*deleter)(void *);
+        uint64_t epoch;
+    };
+
+    // one cache line per thread, only the owner writes it
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> epoch{INACTIVE};
+        std::atomic<bool> claimed{false};
+        int depth = 0;                // nested guards
+        std::vector<Retired> retired; // owner only
+    };
+
+    std::atomic<uint64_t> global_epoch{1};
+    const uint64_t id; // never reused, keys the per-thread slot cache
+    Slot slots[MAX_THREADS];
+
+    static uint64_t next_id()
+    {
+        static std::atomic<uint64_t> ids{1};
+        return ids.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Slot &my_slot()
+    {
+        // fast path: the manager this thread used last
+        struct Cache
+        {
+            uint64_t id = 0;
+            Slot *slot = nullptr;
+        };
+        thread_local Cache cache;
+        thread_local std::vector<std::pair<uint64_t, Slot *>> owned;
+
+        if (cache.id == id)
+        {
+            return *cache.slot;
+        }
+
+        Slot *slot = nullptr;
+        for (auto &entry : owned)
+        {
+            if (entry.first == id)
+            {
+                slot = entry.second;
+                break;
+            }
+        }
+        if (!slot)
+        {
+            slot = claim_slot();
+            owned.emplace_back(id, slot);
+        }
+        cache.id = id;
+        cache.slot = slot;
+        return *slot;
+    }
+
+    Slot *claim_slot()
+    {
+        for (Slot &slot : slots)
+        {
+            bool expected = false;
+            if (!slot.claimed.load(std::memory_order_relaxed) &&
+                slot.claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+            {
+                return &slot;
+            }
+        }
+        throw std::runtime_error("EpochManager out of thread slots");
+    }
+
+    // bump the epoch and free what no active thread can still see
+    void collect(Slot &self)
+    {
+        global_epoch.fetch_add(1, std::memory_order_seq_cst);
+
+        uint64_t min_active = INACTIVE;
+        for (const Slot &slot : slots)
+        {
+            uint64_t e = slot.epoch.load(std::memory_order_seq_cst);
+            if (e < min_active)
+            {
+                min_active = e;
+            }
+        }
+
+        size_t kept = 0;
+        for (Retired &r : self.retired)
+        {
+            if (r.epoch < min_active)
+            {
+                r.deleter(r.ptr);
+            }
+            else
+            {
+                self.retired[kept++] = r;
+            }
+        }
+        self.retired.resize(kept);
+    }
+
+public:
+    EpochManager() : id(next_id()) {}
+
+    EpochManager(const EpochManager &) = delete;
+    EpochManager &operator=(const EpochManager &) = delete;
+
+    // no thread may be inside a Guard anymore
+    ~EpochManager()
+    {
+        for (Slot &slot : slots)
+        {
+            for (Retired &r : slot.retired)
+            {
+                r.deleter(r.ptr);
+            }
+        }
+    }
+
+    // pins the current epoch for the lifetime of the guard, nests
+    class Guard
+    {
+        Slot *slot;
+
+    public:
+        explicit Guard(EpochManager &manager) : slot(&manager.my_slot())
+        {
+            if (slot->depth++ == 0)
+            {
+                // seq_cst: the announcement must be visible before any shared pointer is read
+                slot->epoch.store(manager.global_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+            }
+        }
+
+        ~Guard()
+        {
+            if (--slot->depth == 0)
+            {
+                slot->epoch.store(INACTIVE, std::memory_order_release);
+            }
+        }
+
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+    };
+
+    // ptr is already unreachable for new readers; deleter(ptr) runs once the old ones are gone
+    void retire(void *ptr, void (*deleter)(void *))
+    {
+        Slot &self = my_slot();
+        self.retired.push_back({ptr, deleter, global_epoch.load(std::memory_order_seq_cst)});
+        if (self.retired.size() >= COLLECT_THRESHOLD)
+        {
+            collect(self);
+        }
+    }
+
+    uint64_t current_epoch() const
+    {
+        return global_epoch.load(std::memory_order_relaxed);
+    }
+};
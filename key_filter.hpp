@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// --- KEY FILTERS ---
+// optional membership filter a tree checks before a point lookup descends, so most lookups for
+// absent keys return without touching a node. A filter policy provides Set<K>:
+//   Set<K>::enabled                 -> false compiles every filter call in the tree away
+//   Set<K>::reset(expected_keys)    -> drop all keys, size for expected_keys
+//   Set<K>::add(key)                -> key is in the tree now
+//   Set<K>::may_contain(key)        -> false only for keys not added since the last reset
+//   Set<K>::capacity() / bytes()    -> keys it was sized for, memory it holds
+// removed keys can't be taken out again: the tree counts them and rebuilds the filter from its
+// leaves once live + removed keys pass capacity (the same check grows it as the tree grows)
+
+// no filter (the default)
+struct NoFilter
+{
+    template <typename K>
+    struct Set
+    {
+        static constexpr bool enabled = false;
+
+        void reset(size_t) {}
+        void add(K) {}
+        bool may_contain(K) const { return true; }
+        size_t capacity() const { return SIZE_MAX; }
+        size_t bytes() const { return 0; }
+    };
+};
+
+// split-block Bloom filter (the Parquet / Impala layout): a key hashes to one 32-byte block and
+// sets one bit in each of its 8 words, so a probe is one cache line and 8 independent word tests
+// that compile to a single vector compare. At BitsPerKey = 10 about 1% of absent keys get through,
+// 16 bits -> ~0.1%. Rebuilds size it for twice the live keys, so it holds 1-2x BitsPerKey bits per key
+template <int BitsPerKey = 10>
+struct BloomFilter
+{
+    static_assert(BitsPerKey >= 4 && BitsPerKey <= 64, "BloomFilter wants 4..64 bits per key");
+
+    template <typename K>
+    class Set
+    {
+        struct alignas(32) Block
+        {
+            uint32_t words[8];
+        };
+
+        // small trees don't churn through rebuilds
+        static constexpr size_t MIN_CAPACITY = 1024;
+
+        static constexpr uint32_t SALT[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                             0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+        std::vector<Block> blocks;
+        size_t cap = 0;
+
+        // std::hash is the identity for integers, so finish it with the splitmix64 mixer
+        static uint64_t hash(K key)
+        {
+            uint64_t x = (uint64_t)std::hash<K>{}(key);
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+            return x ^ (x >> 31);
+        }
+
+        // high 32 bits pick the block (multiply-shift instead of a modulo), low 32 bits the bits
+        size_t block_of(uint64_t h) const
+        {
+            return (size_t)(((h >> 32) * (uint64_t)blocks.size()) >> 32);
+        }
+
+    public:
+        static constexpr bool enabled = true;
+
+        Set() { reset(0); }
+
+        void reset(size_t expected_keys)
+        {
+            cap = std::max(expected_keys, MIN_CAPACITY);
+            size_t num_blocks = (cap * BitsPerKey + 255) / 256;
+            blocks.assign(num_blocks, Block{});
+        }
+
+        void add(K key)
+        {
+            uint64_t h = hash(key);
+            Block &block = blocks[block_of(h)];
+            for (int i = 0; i < 8; i++)
+            {
+                block.words[i] |= 1U << (((uint32_t)h * SALT[i]) >> 27);
+            }
+        }
+
+        bool may_contain(K key) const
+        {
+            uint64_t h = hash(key);
+            const Block &block = blocks[block_of(h)];
+            uint32_t missing = 0;
+            for (int i = 0; i < 8; i++)
+            {
+                missing |= ~block.words[i] & (1U << (((uint32_t)h * SALT[i]) >> 27));
+            }
+            return missing == 0;
+        }
+
+        size_t capacity() const { return cap; }
+        size_t bytes() const { return blocks.size() * sizeof(Block); }
+    };
+};
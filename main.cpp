@@ -1,27 +1,123 @@
 #include "bplustree.hpp"
+#include "buffered_bplustree.hpp"
+#include "bench_timer.hpp"
 #include <iostream>
 #include <vector>
 #include <algorithm>
 #include <chrono>
 #include <random>
+#include <iomanip>
+#include <string>
 
 using namespace std;
 
-// define global arena
-Arena* global_arena = nullptr;
-const size_t ARENA_SIZE = 1ULL * 1024 * 1024 * 1024; // 1 GB
+const size_t ARENA_INITIAL_SIZE = 64ULL * 1024 * 1024;  // 64 MB, grows in chunks from here
+const size_t ARENA_MAX_SIZE = 1ULL * 1024 * 1024 * 1024; // 1 GB
+
+CycleTimer timer;
+
+// inserts every key into a fresh tree (private arena) through one insert path and prints
+// avg / P50 / P99 per insert
+template<int M, typename Insert>
+void run_insert_variant(const char* label, const vector<int>& keys, Insert insert) {
+    BPlusTree<int, int, M> tree;
+    LatencyHistogram hist;
+    auto start = chrono::steady_clock::now();
+    for (int key : keys) {
+        uint64_t t0 = CycleTimer::start();
+        insert(tree, key);
+        uint64_t t1 = CycleTimer::stop();
+        hist.record((uint64_t)timer.to_ns(t0, t1));
+    }
+    auto end = chrono::steady_clock::now();
+    cout << "  " << left << setw(8) << ("M=" + to_string(M)) << right << label
+         << "  avg " << hist.mean() << " ns, P50 " << hist.percentile(0.50) << " ns, P99 " << hist.percentile(0.99)
+         << " ns, total " << chrono::duration_cast<chrono::milliseconds>(end - start).count() << " ms" << endl;
+}
+
+// per-insert latency of a write-buffered tree (flushes included) plus lookups before the final flush
+template<int BufferSize>
+void run_buffered_insert(const vector<int>& keys) {
+    BufferedBPlusTree<int, int, 256, 256, SortedLayout, BufferSize> tree;
+    LatencyHistogram hist;
+    auto start = chrono::steady_clock::now();
+    for (int key : keys) {
+        uint64_t t0 = CycleTimer::start();
+        tree.insert(key, key * 10);
+        uint64_t t1 = CycleTimer::stop();
+        hist.record((uint64_t)timer.to_ns(t0, t1));
+    }
+    auto end = chrono::steady_clock::now();
+
+    // reads scan the pending buffer first
+    LatencyHistogram reads;
+    for (size_t i = 0; i < keys.size(); i += 7) {
+        int val;
+        uint64_t t0 = CycleTimer::start();
+        bool found = tree.findSIMD(keys[i], val);
+        uint64_t t1 = CycleTimer::stop();
+        reads.record((uint64_t)timer.to_ns(t0, t1));
+        if (!found) cout << "  missing key " << keys[i] << endl;
+    }
+    tree.flush();
+
+    cout << "  " << left << setw(8) << "M=256" << "buffered, B=" << setw(16) << BufferSize << right
+         << "avg " << hist.mean() << " ns, P50 " << hist.percentile(0.50) << " ns, P99 " << hist.percentile(0.99)
+         << " ns, max " << hist.max() << " ns, total " << chrono::duration_cast<chrono::milliseconds>(end - start).count()
+         << " ms | find avg " << reads.mean() << " ns" << endl;
+}
+
+// insert() per key vs insert_batch() over chunks of `batch` keys, same key stream
+void run_batch_insert(const char* label, const vector<int>& keys, size_t batch) {
+    BPlusTree<int, int> loop_tree;
+    auto loop_start = chrono::steady_clock::now();
+    for (int key : keys) {
+        loop_tree.insert(key, key * 10);
+    }
+    auto loop_end = chrono::steady_clock::now();
+
+    BPlusTree<int, int> batch_tree;
+    vector<pair<int, int>> chunk;
+    auto batch_start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); i += batch) {
+        chunk.clear();
+        for (size_t j = i; j < min(keys.size(), i + batch); j++) {
+            chunk.emplace_back(keys[j], keys[j] * 10);
+        }
+        batch_tree.insert_batch(chunk.begin(), chunk.end());
+    }
+    auto batch_end = chrono::steady_clock::now();
+
+    double n = (double)keys.size();
+    cout << "  " << left << setw(16) << label << right
+         << "insert() " << chrono::duration<double, nano>(loop_end - loop_start).count() / n << " ns/key, leaf fill "
+         << loop_tree.stats().leaf_fill_factor * 100 << "% | insert_batch(" << batch << ") "
+         << chrono::duration<double, nano>(batch_end - batch_start).count() / n << " ns/key, leaf fill "
+         << batch_tree.stats().leaf_fill_factor * 100 << "%" << endl;
+}
+
+template<int M>
+void run_insert_variants(const vector<int>& keys) {
+    run_insert_variant<M>("linear scan + element shifts", keys,
+        [](BPlusTree<int, int, M>& t, int k) { t.insertLinear(k, k * 10); });
+    run_insert_variant<M>("binary search + memmove     ", keys,
+        [](BPlusTree<int, int, M>& t, int k) { t.insertBinary(k, k * 10); });
+    run_insert_variant<M>("node kernel + memmove       ", keys,
+        [](BPlusTree<int, int, M>& t, int k) { t.insert(k, k * 10); });
+}
 
 int main()
 {
-    // intialize Arena 
+    // intialize Arena (shared by every tree below, so the memory numbers cover all of them)
     cout << "========================================" << endl;
     cout << "INITIALIZING ARENA ALLOCATOR" << endl;
     cout << "========================================" << endl;
-    global_arena = new Arena(ARENA_SIZE);
-    cout << "Arena capacity: " << (global_arena->get_capacity() / (1024.0 * 1024 * 1024)) << " GB" << endl;
+    Arena arena(ARENA_INITIAL_SIZE, ARENA_MAX_SIZE);
+    cout << "Arena reserved: " << (arena.get_capacity() / (1024.0 * 1024)) << " MB (max "
+         << (arena.get_max_capacity() / (1024.0 * 1024 * 1024)) << " GB)" << endl;
     cout << "========================================\n" << endl;
 
-    BPlusTree<int, int> tree;
+    BPlusTree<int, int> tree(arena);
     const int N = 1000000;
 
     // ==================== INSERTION LATENCY BENCHMARK ====================
@@ -90,20 +186,175 @@ int main()
     cout << "  Maximum:     " << max_insertion_time << " ns" << endl;
     cout << "  95th %ile:   " << p95_insertion_time << " ns" << endl;
     cout << "  99th %ile:   " << p99_insertion_time << " ns" << endl;
+
+    // what the inserts did inside the tree (only counted when built with -DBPT_STATS)
+    if (BPlusTree<int, int>::counters_enabled()) {
+        const BPlusTreeCounters& counters = tree.op_counters();
+        double inserts = (double)max<uint64_t>(1, counters.inserts);
+        cout << "\nTree counters (per insert):" << endl;
+        cout << "  Nodes visited: " << counters.insert_nodes / inserts << endl;
+        cout << "  Keys shifted:  " << counters.keys_shifted / inserts << endl;
+        cout << "  Leaf splits:   " << counters.leaf_splits / inserts << " (" << counters.leaf_splits << " total)" << endl;
+        cout << "  Inner splits:  " << counters.inner_splits / inserts << " (" << counters.inner_splits << " total)" << endl;
+    }
     
     cout << "\n--- ARENA MEMORY USAGE ---" << endl;
-    double used_mb = global_arena->get_used_memory() / (1024.0 * 1024.0);
-    double capacity_mb = global_arena->get_capacity() / (1024.0 * 1024.0);
-    double usage_percent = (global_arena->get_used_memory() * 100.0) / global_arena->get_capacity();
+    double used_mb = arena.get_used_memory() / (1024.0 * 1024.0);
+    double capacity_mb = arena.get_capacity() / (1024.0 * 1024.0);
+    double usage_percent = (arena.get_used_memory() * 100.0) / arena.get_capacity();
     cout << "  Used:        " << used_mb << " MB" << endl;
-    cout << "  Capacity:    " << capacity_mb << " MB" << endl;
+    cout << "  Reserved:    " << capacity_mb << " MB in " << arena.get_chunk_count() << " chunk(s)" << endl;
     cout << "  Usage:       " << usage_percent << "%" << endl;
-    cout << "  Bytes/Node:  ~" << (global_arena->get_used_memory() / N) << " bytes (average)" << endl;
+    cout << "  Leaf size:   " << BPlusTree<int, int>::leaf_node_bytes() << " bytes" << endl;
+    cout << "  Inner size:  " << BPlusTree<int, int>::internal_node_bytes() << " bytes" << endl;
+
+    BPlusTreeStats stats = tree.stats();
+    cout << "\n--- TREE STATS ---" << endl;
+    cout << "  Keys:        " << stats.keys << endl;
+    cout << "  Height:      " << stats.height << " (nodes per level:";
+    for (size_t n : stats.nodes_per_level) cout << " " << n;
+    cout << ")" << endl;
+    cout << "  Leaves:      " << stats.leaf_nodes << ", fill " << stats.leaf_fill_factor * 100 << "%" << endl;
+    cout << "  Internal:    " << stats.internal_nodes << ", fill " << stats.internal_fill_factor * 100 << "%" << endl;
+    cout << "  Leaf fill:  ";
+    for (int b = 0; b < BPlusTreeStats::FILL_BUCKETS; b++) cout << " " << b * 10 << "%:" << stats.leaf_fill[b];
+    cout << endl;
+    cout << "  Tree bytes:  " << stats.total_bytes / (1024.0 * 1024.0) << " MB, "
+         << stats.wasted_bytes / (1024.0 * 1024.0) << " MB in empty slots / free lists" << endl;
+    cout << "  Bytes/Key:   " << stats.bytes_per_key << " (payload " << sizeof(int) + sizeof(int) << ")" << endl;
+    cout << "========================================\n" << endl;
+
+    // ==================== STEADY-STATE CHURN BENCHMARK ====================
+    cout << "========================================" << endl;
+    cout << "STEADY-STATE CHURN (DELETE + INSERT)" << endl;
+    cout << "========================================" << endl;
+
+    // each op removes a random live key and inserts a fresh one, so the key count stays at N
+    const int CHURN_ROUNDS = 5;
+    const int CHURN_OPS = N / 5;
+    vector<int> live_keys = random_keys;
+    vector<long long> churn_times(CHURN_OPS);
+
+    cout << "\n" << "Round  Avg(ns)  P99(ns)  Arena(MB)" << endl;
+    for (int r = 0; r < CHURN_ROUNDS; r++) {
+        long long churn_total = 0;
+        for (int i = 0; i < CHURN_OPS; i++) {
+            size_t victim = gen() % live_keys.size();
+            int fresh = dist(gen);
+
+            auto start = chrono::high_resolution_clock::now();
+            tree.remove(live_keys[victim]);
+            tree.insert(fresh, fresh * 10);
+            auto end = chrono::high_resolution_clock::now();
+
+            live_keys[victim] = fresh;
+            churn_times[i] = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+            churn_total += churn_times[i];
+        }
+        sort(churn_times.begin(), churn_times.end());
+        cout << "  " << r + 1
+             << "    " << churn_total / CHURN_OPS
+             << "      " << churn_times[(int)(CHURN_OPS * 0.99)]
+             << "      " << arena.get_used_memory() / (1024.0 * 1024.0) << endl;
+    }
+    cout << "========================================\n" << endl;
+
+    // ==================== INSERT PATH VARIANTS ====================
+    cout << "========================================" << endl;
+    cout << "INSERT PATH VARIANTS (" << simd_isa_name(active_simd_isa()) << " node kernel)" << endl;
+    cout << "========================================" << endl;
+
+    timer.calibrate();
+    run_insert_variants<64>(random_keys);
+    run_insert_variants<256>(random_keys);
+    run_insert_variants<1024>(random_keys);
     cout << "========================================\n" << endl;
 
-    // clean up arena
-    delete global_arena;
-    global_arena = nullptr;
+    // ==================== WRITE-BUFFERED INSERTS ====================
+    // straight insert loop vs front buffer + merge per flush, for the random keys and for
+    // sensor-style bursts (512 rising keys from one of 64 sensors at a time)
+    cout << "========================================" << endl;
+    cout << "WRITE-BUFFERED INSERTS (sorted batches merged per flush)" << endl;
+    cout << "========================================" << endl;
+
+    vector<int> burst_keys(N);
+    vector<int> sensor_clock(64, 0);
+    for (int i = 0; i < N; i += 512) {
+        int sensor = gen() % 64;
+        for (int j = 0; j < 512 && i + j < N; j++) {
+            sensor_clock[sensor] += 1 + gen() % 8;
+            burst_keys[i + j] = sensor * (N / 8) + sensor_clock[sensor];
+        }
+    }
+
+    for (const vector<int>* keys : {&random_keys, &burst_keys}) {
+        cout << (keys == &random_keys ? "Random keys:" : "Sensor bursts:") << endl;
+        run_insert_variant<256>("straight insert()           ", *keys,
+            [](BPlusTree<int, int, 256>& t, int k) { t.insert(k, k * 10); });
+        run_buffered_insert<256>(*keys);
+        run_buffered_insert<1024>(*keys);
+        run_buffered_insert<4096>(*keys);
+    }
+    cout << "========================================\n" << endl;
+
+    // ==================== BATCHED SORTED INSERTS ====================
+    // cursor path reuse + 90/10 splits on appends vs one descent per key (M=256)
+    cout << "========================================" << endl;
+    cout << "BATCHED SORTED INSERTS (insert_batch)" << endl;
+    cout << "========================================" << endl;
+
+    vector<int> ascending_keys(N);
+    for (int i = 0; i < N; i++) {
+        ascending_keys[i] = i * 10 + (int)(gen() % 10); // log-index style: rising, not dense
+    }
+    run_batch_insert("ascending", ascending_keys, 1000);
+    run_batch_insert("sensor bursts", burst_keys, 1000);
+    run_batch_insert("random", random_keys, 1000);
+    cout << "========================================\n" << endl;
+
+    // ==================== BULK LOAD vs INCREMENTAL BUILD ====================
+    cout << "========================================" << endl;
+    cout << "BULK LOAD vs INCREMENTAL BUILD" << endl;
+    cout << "========================================" << endl;
+
+    vector<pair<int, int>> entries(N);
+    for (int i = 0; i < N; i++) {
+        entries[i] = {random_keys[i], random_keys[i] * 10};
+    }
+
+    // incremental: one insert per key, no per-op timers this time
+    size_t arena_before = arena.get_used_memory();
+    auto incr_start = chrono::high_resolution_clock::now();
+    BPlusTree<int, int> incremental_tree(arena);
+    for (int i = 0; i < N; i++) {
+        incremental_tree.insert(entries[i].first, entries[i].second);
+    }
+    auto incr_end = chrono::high_resolution_clock::now();
+    size_t incr_bytes = arena.get_used_memory() - arena_before;
+
+    cout << "\n--- BUILD RESULTS ---" << endl;
+    cout << "  Incremental insert:     "
+         << chrono::duration_cast<chrono::milliseconds>(incr_end - incr_start).count() << " ms, "
+         << (incr_bytes / (1024.0 * 1024.0)) << " MB arena" << endl;
+
+    // bulk: sort the snapshot once, then build bottom-up
+    for (double fill : {1.0, 0.9, 0.7}) {
+        vector<pair<int, int>> snapshot = entries;
+        arena_before = arena.get_used_memory();
+        auto bulk_start = chrono::high_resolution_clock::now();
+        sort(snapshot.begin(), snapshot.end());
+        auto sort_end = chrono::high_resolution_clock::now();
+        BPlusTree<int, int> bulk_tree(arena);
+        bulk_tree.bulk_load(snapshot.begin(), snapshot.end(), fill);
+        auto bulk_end = chrono::high_resolution_clock::now();
+        size_t bulk_bytes = arena.get_used_memory() - arena_before;
+
+        cout << "  Sort + bulk_load (fill " << fill << "): "
+             << chrono::duration_cast<chrono::milliseconds>(bulk_end - bulk_start).count() << " ms ("
+             << chrono::duration_cast<chrono::milliseconds>(bulk_end - sort_end).count() << " ms load), "
+             << (bulk_bytes / (1024.0 * 1024.0)) << " MB arena" << endl;
+    }
+    cout << "========================================\n" << endl;
 
     return 0;
 }
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+
+#include "node_search.hpp"
+
+// --- INTRA-NODE KEY LAYOUTS ---
+// keys[] always stays one sorted array (inserts / splits / merges shift it as before). A layout
+// policy adds an optional per-node index in front of it and decides how a node is searched:
+//   Index<K, M>::rebuild(keys, n)                     -> refresh after keys[0..n) changed
+//   Index<K, M>::upper_bound(kern, keys, n, key)      -> first index with keys[i] > key
+//   Index<K, M>::find(kern, keys, n, key)             -> index of key, -1 if absent
+// nodes inherit the index, so an empty one costs no space.
+
+// plain sorted array, searched directly (the default)
+struct SortedLayout
+{
+    template <typename K, int M>
+    struct Index
+    {
+        void rebuild(const K *, int) {}
+
+        int upper_bound(const SearchKernels<K> &kern, const K *keys, int n, K key) const
+        {
+            return kern.upper_bound(keys, n, key);
+        }
+
+        int find(const SearchKernels<K> &kern, const K *keys, int n, K key) const
+        {
+            return kern.find(keys, n, key);
+        }
+    };
+};
+
+// two-level block: keys[] is cut into cache-line sized blocks (16 ints / 8 int64) and a summary
+// holds the largest key of each block. A search scans the summary (one line for M = 256 ints)
+// and then one data line, instead of up to M / 16 lines of keys[]
+struct BlockedLayout
+{
+    template <typename K, int M>
+    struct Index
+    {
+        static constexpr int BLOCK = sizeof(K) >= 64 ? 1 : (int)(64 / sizeof(K));
+        static constexpr int NUM_BLOCKS = (M + BLOCK - 1) / BLOCK;
+
+        // block_max[b] = keys[min((b + 1) * BLOCK, n) - 1], first ceil(n / BLOCK) entries valid
+        alignas(64) K block_max[NUM_BLOCKS];
+
+        static int blocks(int n) { return (n + BLOCK - 1) / BLOCK; }
+
+        void rebuild(const K *keys, int n)
+        {
+            int nb = blocks(n);
+            for (int b = 0; b < nb; b++)
+            {
+                block_max[b] = keys[std::min((b + 1) * BLOCK, n) - 1];
+            }
+        }
+
+        int upper_bound(const SearchKernels<K> &kern, const K *keys, int n, K key) const
+        {
+            int nb = blocks(n);
+            // every block before b is <= key, so the answer is in block b
+            int b = kern.upper_bound(block_max, nb, key);
+            if (b == nb)
+            {
+                return n;
+            }
+            int off = b * BLOCK;
+            return off + kern.upper_bound(keys + off, std::min(BLOCK, n - off), key);
+        }
+
+        int find(const SearchKernels<K> &kern, const K *keys, int n, K key) const
+        {
+            int nb = blocks(n);
+            int b = kern.upper_bound(block_max, nb, key);
+            // key is the last slot of the previous block, answered from the summary line
+            if (b > 0 && block_max[b - 1] == key)
+            {
+                return std::min(b * BLOCK, n) - 1;
+            }
+            if (b == nb)
+            {
+                return -1;
+            }
+            int off = b * BLOCK;
+            int i = kern.find(keys + off, std::min(BLOCK, n - off), key);
+            return i < 0 ? -1 : off + i;
+        }
+    };
+};
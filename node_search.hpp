@@ -0,0 +1,795 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BPT_ARCH_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define BPT_ARCH_NEON 1
+#include <arm_neon.h>
+#endif
+
+// --- NODE SEARCH KERNELS ---
+// KeySearch<K> is picked at compile time from the key's width / signedness / float-ness and
+// hands out a table of kernels for the instruction set chosen at runtime:
+//   upper_bound(keys, n, key) -> first index with keys[i] > key, n if none (child to descend into)
+//   find(keys, n, key)        -> index of keys[i] == key, -1 if absent (leaf lookup)
+// every vector kernel walks full vectors with an early exit on the first hit and finishes
+// the last n % lanes keys in scalar, so it never reads past n.
+//   upper_bound_branchless(keys, n, cap, key) -> same answer as upper_bound, but popcounts
+// `node_key <= key` over every vector that overlaps [0, n) with no exit on the data. Slots past
+// n (up to cap, the node's capacity) must hold key_sentinel<K>().
+//
+// each kernel is compiled with its own target attribute, so the header builds without -mavx2 /
+// -mavx512f and the best variant the CPU supports is resolved once at startup (cpuid).
+
+inline void prefetch_t0(const void *p)
+{
+    __builtin_prefetch(p, 0, 3);
+}
+
+// --- RUNTIME DISPATCH ---
+enum class SimdIsa : int
+{
+    Scalar = 0,
+    SSE42,
+    AVX2,
+    AVX512,
+    NEON,
+    Count
+};
+
+inline const char *simd_isa_name(SimdIsa isa)
+{
+    switch (isa)
+    {
+    case SimdIsa::Scalar: return "Scalar";
+    case SimdIsa::SSE42: return "SSE4.2";
+    case SimdIsa::AVX2: return "AVX2";
+    case SimdIsa::AVX512: return "AVX-512";
+    case SimdIsa::NEON: return "NEON";
+    default: return "?";
+    }
+}
+
+// can this binary run `isa` on this CPU
+inline bool simd_isa_supported(SimdIsa isa)
+{
+    switch (isa)
+    {
+    case SimdIsa::Scalar:
+        return true;
+#if BPT_ARCH_X86
+    case SimdIsa::SSE42:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+    case SimdIsa::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    case SimdIsa::AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt");
+#endif
+#if BPT_ARCH_NEON
+    case SimdIsa::NEON:
+        return true; // baseline on aarch64
+#endif
+    default:
+        return false;
+    }
+}
+
+inline SimdIsa detect_simd_isa()
+{
+    for (SimdIsa isa : {SimdIsa::AVX512, SimdIsa::AVX2, SimdIsa::NEON, SimdIsa::SSE42})
+    {
+        if (simd_isa_supported(isa))
+        {
+            return isa;
+        }
+    }
+    return SimdIsa::Scalar;
+}
+
+// the variant every KeySearch<K>::active() call uses, detected on first use
+inline std::atomic<int> &simd_isa_slot()
+{
+    static std::atomic<int> slot{(int)detect_simd_isa()};
+    return slot;
+}
+
+inline SimdIsa active_simd_isa()
+{
+    return (SimdIsa)simd_isa_slot().load(std::memory_order_relaxed);
+}
+
+// force a variant (benchmarks / tests), returns false and keeps the current one if unsupported
+inline bool set_simd_isa(SimdIsa isa)
+{
+    if (!simd_isa_supported(isa))
+    {
+        return false;
+    }
+    simd_isa_slot().store((int)isa, std::memory_order_relaxed);
+    return true;
+}
+
+enum class KeyKind
+{
+    Other,
+    Signed32,
+    Unsigned32,
+    Signed64,
+    Unsigned64,
+    Float32,
+    Float64
+};
+
+template <typename K>
+constexpr KeyKind key_kind()
+{
+    if (std::is_floating_point<K>::value)
+    {
+        return sizeof(K) == 4 ? KeyKind::Float32 : (sizeof(K) == 8 ? KeyKind::Float64 : KeyKind::Other);
+    }
+    if (std::is_integral<K>::value && !std::is_same<K, bool>::value)
+    {
+        if (sizeof(K) == 4)
+            return std::is_signed<K>::value ? KeyKind::Signed32 : KeyKind::Unsigned32;
+        if (sizeof(K) == 8)
+            return std::is_signed<K>::value ? KeyKind::Signed64 : KeyKind::Unsigned64;
+    }
+    return KeyKind::Other;
+}
+
+// padding for unused key slots, never smaller than a real key. Results of the branchless
+// kernels are clamped to n, so a real key equal to the sentinel is still handled
+template <typename K>
+constexpr bool has_key_sentinel()
+{
+    return std::is_arithmetic<K>::value;
+}
+
+template <typename K>
+constexpr K key_sentinel()
+{
+    return std::numeric_limits<K>::has_infinity ? std::numeric_limits<K>::infinity() : std::numeric_limits<K>::max();
+}
+
+template <typename K>
+struct SearchKernels
+{
+    int (*upper_bound)(const K *keys, int n, K key);
+    int (*find)(const K *keys, int n, K key);
+    int (*upper_bound_branchless)(const K *keys, int n, int cap, K key);
+};
+
+// --- SCALAR ---
+// same early-exit linear walk as the vector kernels, one key at a time
+namespace scalar_search
+{
+    template <typename K>
+    int upper_bound(const K *keys, int n, K key)
+    {
+        int i = 0;
+        while (i < n && !(key < keys[i]))
+        {
+            i++;
+        }
+        return i;
+    }
+
+    template <typename K>
+    int find(const K *keys, int n, K key)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            if (keys[i] == key)
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    template <typename K>
+    int upper_bound_branchless(const K *keys, int n, int, K key)
+    {
+        int le = 0;
+        for (int i = 0; i < n; i++)
+        {
+            le += !(key < keys[i]);
+        }
+        return le;
+    }
+
+    template <typename K>
+    int binary_upper_bound(const K *keys, int n, K key)
+    {
+        return std::upper_bound(keys, keys + n, key) - keys;
+    }
+
+    template <typename K>
+    int binary_find(const K *keys, int n, K key)
+    {
+        int i = std::lower_bound(keys, keys + n, key) - keys;
+        return (i < n && keys[i] == key) ? i : -1;
+    }
+
+    template <typename K>
+    int binary_upper_bound_branchless(const K *keys, int n, int, K key)
+    {
+        return binary_upper_bound(keys, n, key);
+    }
+}
+
+// shared vector loops, stamped once per instruction set so they are compiled with (and can
+// inline) that set's Ops. Ops supplies Lanes, set1, gt_mask and eq_mask (bit i = lane i)
+#define BPT_DEFINE_SEARCH_LOOPS(TARGET)                                \
+    template <typename K, typename Ops>                                \
+    TARGET int upper_bound(const K *keys, int n, K key)                \
+    {                                                                  \
+        auto target_vec = Ops::set1(key);                              \
+        int i = 0;                                                     \
+        for (; i + Ops::Lanes <= n; i += Ops::Lanes)                   \
+        {                                                              \
+            /* Prefetch next chunk of keys */                          \
+            prefetch_t0(&keys[i + Ops::Lanes]);                        \
+            /* is NodeKey > SearchKey? */                              \
+            unsigned mask = Ops::gt_mask(keys + i, target_vec);        \
+            if (__builtin_expect(mask != 0, 0))                        \
+            {                                                          \
+                return i + __builtin_ctz(mask);                        \
+            }                                                          \
+        }                                                              \
+        while (i < n && !(key < keys[i]))                              \
+        {                                                              \
+            i++;                                                       \
+        }                                                              \
+        return i;                                                      \
+    }                                                                  \
+                                                                       \
+    template <typename K, typename Ops>                                \
+    TARGET int find(const K *keys, int n, K key)                       \
+    {                                                                  \
+        auto target_vec = Ops::set1(key);                              \
+        int i = 0;                                                     \
+        for (; i + Ops::Lanes <= n; i += Ops::Lanes)                   \
+        {                                                              \
+            prefetch_t0(&keys[i + Ops::Lanes]);                        \
+            unsigned mask = Ops::eq_mask(keys + i, target_vec);        \
+            if (__builtin_expect(mask != 0, 0))                        \
+            {                                                          \
+                return i + __builtin_ctz(mask);                        \
+            }                                                          \
+        }                                                              \
+        for (; i < n; i++)                                             \
+        {                                                              \
+            if (keys[i] == key)                                        \
+            {                                                          \
+                return i;                                              \
+            }                                                          \
+        }                                                              \
+        return -1;                                                     \
+    }                                                                  \
+                                                                       \
+    template <typename K, typename Ops>                                \
+    TARGET int upper_bound_branchless(const K *keys, int n, int cap,   \
+                                      K key)                           \
+    {                                                                  \
+        auto target_vec = Ops::set1(key);                              \
+        int gt = 0;                                                    \
+        int i = 0;                                                     \
+        /* trip count only depends on n, never on the keys */          \
+        for (; i < n && i + Ops::Lanes <= cap; i += Ops::Lanes)        \
+        {                                                              \
+            unsigned mask = Ops::gt_mask(keys + i, target_vec);        \
+            gt += __builtin_popcount(mask);                            \
+        }                                                              \
+        int le = i - gt;                                               \
+        for (; i < n; i++)                                             \
+        {                                                              \
+            le += !(key < keys[i]);                                    \
+        }                                                              \
+        /* sentinel slots count as <= when key is the sentinel */      \
+        return le < n ? le : n;                                        \
+    }
+
+#if BPT_ARCH_X86
+
+#define BPT_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define BPT_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define BPT_TARGET_AVX512 __attribute__((target("avx512f,popcnt")))
+
+// --- SSE4.2 (4 x 32-bit / 2 x 64-bit lanes) ---
+namespace sse42_search
+{
+    template <KeyKind Kind>
+    struct Ops;
+
+    template <>
+    struct Ops<KeyKind::Signed32>
+    {
+        static constexpr int Lanes = 4;
+        BPT_TARGET_SSE42 static __m128i set1(int32_t key) { return _mm_set1_epi32(key); }
+        BPT_TARGET_SSE42 static unsigned gt_mask(const void *p, __m128i key)
+        {
+            __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+            return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(chunk, key)));
+        }
+        BPT_TARGET_SSE42 static unsigned eq_mask(const void *p, __m128i key)
+        {
+            __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+            return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(chunk, key)));
+        }
+    };
+
+    // no unsigned compare before AVX-512: flipping the sign bit of both sides maps unsigned order onto signed order
+    template <>
+    struct Ops<KeyKind::Unsigned32>
+    {
+        static constexpr int Lanes = 4;
+        BPT_TARGET_SSE42 static __m128i bias() { return _mm_set1_epi32((int32_t)0x80000000u); }
+        BPT_TARGET_SSE42 static __m128i set1(uint32_t key) { return _mm_xor_si128(_mm_set1_epi32((int32_t)key), bias()); }
+        BPT_TARGET_SSE42 static unsigned gt_mask(const void *p, __m128i key)
+        {
+            __m128i chunk = _mm_xor_si128(_mm_loadu_si128((const __m128i *)p), bias());
+            return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(chunk, key)));
+        }
+        BPT_TARGET_SSE42 static unsigned eq_mask(const void *p, __m128i key)
+        {
+            __m128i chunk = _mm_xor_si128(_mm_loadu_si128((const __m128i *)p), bias());
+            return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(chunk, key)));
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Signed64>
+    {
+        static constexpr int Lanes = 2;
+        BPT_TARGET_SSE42 static __m128i set1(int64_t key) { return _mm_set1_epi64x(key); }
+        BPT_TARGET_SSE42 static unsigned gt_mask(const void *p, __m128i key)
+        {
+            __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+            return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(chunk, key)));
+        }
+        BPT_TARGET_SSE42 static unsigned eq_mask(const void *p, __m128i key)
+        {
+            __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+            return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(chunk, key)));
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Unsigned64>
+    {
+        static constexpr int Lanes = 2;
+        BPT_TARGET_SSE42 static __m128i bias() { return _mm_set1_epi64x((int64_t)0x8000000000000000ull); }
+        BPT_TARGET_SSE42 static __m128i set1(uint64_t key) { return _mm_xor_si128(_mm_set1_epi64x((int64_t)key), bias()); }
+        BPT_TARGET_SSE42 static unsigned gt_mask(const void *p, __m128i key)
+        {
+            __m128i chunk = _mm_xor_si128(_mm_loadu_si128((const __m128i *)p), bias());
+            return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(chunk, key)));
+        }
+        BPT_TARGET_SSE42 static unsigned eq_mask(const void *p, __m128i key)
+        {
+            __m128i chunk = _mm_xor_si128(_mm_loadu_si128((const __m128i *)p), bias());
+            return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(chunk, key)));
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Float32>
+    {
+        static constexpr int Lanes = 4;
+        BPT_TARGET_SSE42 static __m128 set1(float key) { return _mm_set1_ps(key); }
+        BPT_TARGET_SSE42 static unsigned gt_mask(const void *p, __m128 key)
+        {
+            return _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps((const float *)p), key));
+        }
+        BPT_TARGET_SSE42 static unsigned eq_mask(const void *p, __m128 key)
+        {
+            return _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps((const float *)p), key));
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Float64>
+    {
+        static constexpr int Lanes = 2;
+        BPT_TARGET_SSE42 static __m128d set1(double key) { return _mm_set1_pd(key); }
+        BPT_TARGET_SSE42 static unsigned gt_mask(const void *p, __m128d key)
+        {
+            return _mm_movemask_pd(_mm_cmpgt_pd(_mm_loadu_pd((const double *)p), key));
+        }
+        BPT_TARGET_SSE42 static unsigned eq_mask(const void *p, __m128d key)
+        {
+            return _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd((const double *)p), key));
+        }
+    };
+
+    BPT_DEFINE_SEARCH_LOOPS(BPT_TARGET_SSE42)
+}
+
+// --- AVX2 (8 x 32-bit / 4 x 64-bit lanes) ---
+namespace avx2_search
+{
+    template <KeyKind Kind>
+    struct Ops;
+
+    template <>
+    struct Ops<KeyKind::Signed32>
+    {
+        static constexpr int Lanes = 8;
+        BPT_TARGET_AVX2 static __m256i set1(int32_t key) { return _mm256_set1_epi32(key); }
+        BPT_TARGET_AVX2 static unsigned gt_mask(const void *p, __m256i key)
+        {
+            __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+            return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(chunk, key)));
+        }
+        BPT_TARGET_AVX2 static unsigned eq_mask(const void *p, __m256i key)
+        {
+            __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+            return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(chunk, key)));
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Unsigned32>
+    {
+        static constexpr int Lanes = 8;
+        BPT_TARGET_AVX2 static __m256i bias() { return _mm256_set1_epi32((int32_t)0x80000000u); }
+        BPT_TARGET_AVX2 static __m256i set1(uint32_t key) { return _mm256_xor_si256(_mm256_set1_epi32((int32_t)key), bias()); }
+        BPT_TARGET_AVX2 static unsigned gt_mask(const void *p, __m256i key)
+        {
+            __m256i chunk = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p), bias());
+            return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(chunk, key)));
+        }
+        BPT_TARGET_AVX2 static unsigned eq_mask(const void *p, __m256i key)
+        {
+            __m256i chunk = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p), bias());
+            return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(chunk, key)));
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Signed64>
+    {
+        static constexpr int Lanes = 4;
+        BPT_TARGET_AVX2 static __m256i set1(int64_t key) { return _mm256_set1_epi64x(key); }
+        BPT_TARGET_AVX2 static unsigned gt_mask(const void *p, __m256i key)
+        {
+            __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+            return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(chunk, key)));
+        }
+        BPT_TARGET_AVX2 static unsigned eq_mask(const void *p, __m256i key)
+        {
+            __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+            return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(chunk, key)));
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Unsigned64>
+    {
+        static constexpr int Lanes = 4;
+        BPT_TARGET_AVX2 static __m256i bias() { return _mm256_set1_epi64x((int64_t)0x8000000000000000ull); }
+        BPT_TARGET_AVX2 static __m256i set1(uint64_t key) { return _mm256_xor_si256(_mm256_set1_epi64x((int64_t)key), bias()); }
+        BPT_TARGET_AVX2 static unsigned gt_mask(const void *p, __m256i key)
+        {
+            __m256i chunk = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p), bias());
+            return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(chunk, key)));
+        }
+        BPT_TARGET_AVX2 static unsigned eq_mask(const void *p, __m256i key)
+        {
+            __m256i chunk = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p), bias());
+            return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(chunk, key)));
+        }
+    };
+
+    // ordered, non-signalling compares (NaN keys are not supported by the tree anyway)
+    template <>
+    struct Ops<KeyKind::Float32>
+    {
+        static constexpr int Lanes = 8;
+        BPT_TARGET_AVX2 static __m256 set1(float key) { return _mm256_set1_ps(key); }
+        BPT_TARGET_AVX2 static unsigned gt_mask(const void *p, __m256 key)
+        {
+            return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps((const float *)p), key, _CMP_GT_OQ));
+        }
+        BPT_TARGET_AVX2 static unsigned eq_mask(const void *p, __m256 key)
+        {
+            return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps((const float *)p), key, _CMP_EQ_OQ));
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Float64>
+    {
+        static constexpr int Lanes = 4;
+        BPT_TARGET_AVX2 static __m256d set1(double key) { return _mm256_set1_pd(key); }
+        BPT_TARGET_AVX2 static unsigned gt_mask(const void *p, __m256d key)
+        {
+            return _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd((const double *)p), key, _CMP_GT_OQ));
+        }
+        BPT_TARGET_AVX2 static unsigned eq_mask(const void *p, __m256d key)
+        {
+            return _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd((const double *)p), key, _CMP_EQ_OQ));
+        }
+    };
+
+    BPT_DEFINE_SEARCH_LOOPS(BPT_TARGET_AVX2)
+}
+
+// --- AVX-512 (16 x 32-bit / 8 x 64-bit lanes, compares produce the mask directly) ---
+namespace avx512_search
+{
+    template <KeyKind Kind>
+    struct Ops;
+
+    template <>
+    struct Ops<KeyKind::Signed32>
+    {
+        static constexpr int Lanes = 16;
+        BPT_TARGET_AVX512 static __m512i set1(int32_t key) { return _mm512_set1_epi32(key); }
+        BPT_TARGET_AVX512 static unsigned gt_mask(const void *p, __m512i key)
+        {
+            return _mm512_cmpgt_epi32_mask(_mm512_loadu_si512(p), key);
+        }
+        BPT_TARGET_AVX512 static unsigned eq_mask(const void *p, __m512i key)
+        {
+            return _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(p), key);
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Unsigned32>
+    {
+        static constexpr int Lanes = 16;
+        BPT_TARGET_AVX512 static __m512i set1(uint32_t key) { return _mm512_set1_epi32((int32_t)key); }
+        BPT_TARGET_AVX512 static unsigned gt_mask(const void *p, __m512i key)
+        {
+            return _mm512_cmpgt_epu32_mask(_mm512_loadu_si512(p), key);
+        }
+        BPT_TARGET_AVX512 static unsigned eq_mask(const void *p, __m512i key)
+        {
+            return _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(p), key);
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Signed64>
+    {
+        static constexpr int Lanes = 8;
+        BPT_TARGET_AVX512 static __m512i set1(int64_t key) { return _mm512_set1_epi64(key); }
+        BPT_TARGET_AVX512 static unsigned gt_mask(const void *p, __m512i key)
+        {
+            return _mm512_cmpgt_epi64_mask(_mm512_loadu_si512(p), key);
+        }
+        BPT_TARGET_AVX512 static unsigned eq_mask(const void *p, __m512i key)
+        {
+            return _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(p), key);
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Unsigned64>
+    {
+        static constexpr int Lanes = 8;
+        BPT_TARGET_AVX512 static __m512i set1(uint64_t key) { return _mm512_set1_epi64((int64_t)key); }
+        BPT_TARGET_AVX512 static unsigned gt_mask(const void *p, __m512i key)
+        {
+            return _mm512_cmpgt_epu64_mask(_mm512_loadu_si512(p), key);
+        }
+        BPT_TARGET_AVX512 static unsigned eq_mask(const void *p, __m512i key)
+        {
+            return _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(p), key);
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Float32>
+    {
+        static constexpr int Lanes = 16;
+        BPT_TARGET_AVX512 static __m512 set1(float key) { return _mm512_set1_ps(key); }
+        BPT_TARGET_AVX512 static unsigned gt_mask(const void *p, __m512 key)
+        {
+            return _mm512_cmp_ps_mask(_mm512_loadu_ps(p), key, _CMP_GT_OQ);
+        }
+        BPT_TARGET_AVX512 static unsigned eq_mask(const void *p, __m512 key)
+        {
+            return _mm512_cmp_ps_mask(_mm512_loadu_ps(p), key, _CMP_EQ_OQ);
+        }
+    };
+
+    template <>
+    struct Ops<KeyKind::Float64>
+    {
+        static constexpr int Lanes = 8;
+        BPT_TARGET_AVX512 static __m512d set1(double key) { return _mm512_set1_pd(key); }
+        BPT_TARGET_AVX512 static unsigned gt_mask(const void *p, __m512d key)
+        {
+            return _mm512_cmp_pd_mask(_mm512_loadu_pd(p), key, _CMP_GT_OQ);
+        }
+        BPT_TARGET_AVX512 static unsigned eq_mask(const void *p, __m512d key)
+        {
+            return _mm512_cmp_pd_mask(_mm512_loadu_pd(p), key, _CMP_EQ_OQ);
+        }
+    };
+
+    BPT_DEFINE_SEARCH_LOOPS(BPT_TARGET_AVX512)
+}
+
+#endif // BPT_ARCH_X86
+
+#if BPT_ARCH_NEON
+
+// --- NEON (4 x 32-bit / 2 x 64-bit lanes) ---
+// no movemask on NEON: AND the all-ones lanes with their bit weight and add across
+namespace neon_search
+{
+    inline unsigned mask_u32(uint32x4_t cmp)
+    {
+        const uint32x4_t weights = {1, 2, 4, 8};
+        return vaddvq_u32(vandq_u32(cmp, weights));
+    }
+
+    inline unsigned mask_u64(uint64x2_t cmp)
+    {
+        const uint64x2_t weights = {1, 2};
+        return (unsigned)vaddvq_u64(vandq_u64(cmp, weights));
+    }
+
+    template <KeyKind Kind>
+    struct Ops;
+
+    template <>
+    struct Ops<KeyKind::Signed32>
+    {
+        static constexpr int Lanes = 4;
+        static int32x4_t set1(int32_t key) { return vdupq_n_s32(key); }
+        static unsigned gt_mask(const void *p, int32x4_t key) { return mask_u32(vcgtq_s32(vld1q_s32((const int32_t *)p), key)); }
+        static unsigned eq_mask(const void *p, int32x4_t key) { return mask_u32(vceqq_s32(vld1q_s32((const int32_t *)p), key)); }
+    };
+
+    template <>
+    struct Ops<KeyKind::Unsigned32>
+    {
+        static constexpr int Lanes = 4;
+        static uint32x4_t set1(uint32_t key) { return vdupq_n_u32(key); }
+        static unsigned gt_mask(const void *p, uint32x4_t key) { return mask_u32(vcgtq_u32(vld1q_u32((const uint32_t *)p), key)); }
+        static unsigned eq_mask(const void *p, uint32x4_t key) { return mask_u32(vceqq_u32(vld1q_u32((const uint32_t *)p), key)); }
+    };
+
+    template <>
+    struct Ops<KeyKind::Signed64>
+    {
+        static constexpr int Lanes = 2;
+        static int64x2_t set1(int64_t key) { return vdupq_n_s64(key); }
+        static unsigned gt_mask(const void *p, int64x2_t key) { return mask_u64(vcgtq_s64(vld1q_s64((const int64_t *)p), key)); }
+        static unsigned eq_mask(const void *p, int64x2_t key) { return mask_u64(vceqq_s64(vld1q_s64((const int64_t *)p), key)); }
+    };
+
+    template <>
+    struct Ops<KeyKind::Unsigned64>
+    {
+        static constexpr int Lanes = 2;
+        static uint64x2_t set1(uint64_t key) { return vdupq_n_u64(key); }
+        static unsigned gt_mask(const void *p, uint64x2_t key) { return mask_u64(vcgtq_u64(vld1q_u64((const uint64_t *)p), key)); }
+        static unsigned eq_mask(const void *p, uint64x2_t key) { return mask_u64(vceqq_u64(vld1q_u64((const uint64_t *)p), key)); }
+    };
+
+    template <>
+    struct Ops<KeyKind::Float32>
+    {
+        static constexpr int Lanes = 4;
+        static float32x4_t set1(float key) { return vdupq_n_f32(key); }
+        static unsigned gt_mask(const void *p, float32x4_t key) { return mask_u32(vcgtq_f32(vld1q_f32((const float *)p), key)); }
+        static unsigned eq_mask(const void *p, float32x4_t key) { return mask_u32(vceqq_f32(vld1q_f32((const float *)p), key)); }
+    };
+
+    template <>
+    struct Ops<KeyKind::Float64>
+    {
+        static constexpr int Lanes = 2;
+        static float64x2_t set1(double key) { return vdupq_n_f64(key); }
+        static unsigned gt_mask(const void *p, float64x2_t key) { return mask_u64(vcgtq_f64(vld1q_f64((const double *)p), key)); }
+        static unsigned eq_mask(const void *p, float64x2_t key) { return mask_u64(vceqq_f64(vld1q_f64((const double *)p), key)); }
+    };
+
+    BPT_DEFINE_SEARCH_LOOPS()
+}
+
+#endif // BPT_ARCH_NEON
+
+// fallback for anything without a vector compare: plain binary search whatever the ISA
+template <typename K, KeyKind Kind = key_kind<K>()>
+struct KeySearch
+{
+    static constexpr bool has_simd = false;
+
+    static const SearchKernels<K> &kernels(SimdIsa)
+    {
+        static const SearchKernels<K> binary = {&scalar_search::binary_upper_bound<K>, &scalar_search::binary_find<K>,
+                                                &scalar_search::binary_upper_bound_branchless<K>};
+        return binary;
+    }
+
+    static const SearchKernels<K> &active()
+    {
+        return kernels(SimdIsa::Scalar);
+    }
+
+    static int upper_bound(const K *keys, int n, K key) { return scalar_search::binary_upper_bound(keys, n, key); }
+    static int find(const K *keys, int n, K key) { return scalar_search::binary_find(keys, n, key); }
+};
+
+// 32/64-bit integer and float keys: one kernel table per instruction set, indexed by SimdIsa
+template <typename K, KeyKind Kind>
+struct DispatchedKeySearch
+{
+    static constexpr bool has_simd = true;
+
+    static const SearchKernels<K> *table()
+    {
+        static const SearchKernels<K> kernels[(int)SimdIsa::Count] = {
+            {&scalar_search::upper_bound<K>, &scalar_search::find<K>, &scalar_search::upper_bound_branchless<K>},
+#if BPT_ARCH_X86
+            {&sse42_search::upper_bound<K, sse42_search::Ops<Kind>>, &sse42_search::find<K, sse42_search::Ops<Kind>>,
+             &sse42_search::upper_bound_branchless<K, sse42_search::Ops<Kind>>},
+            {&avx2_search::upper_bound<K, avx2_search::Ops<Kind>>, &avx2_search::find<K, avx2_search::Ops<Kind>>,
+             &avx2_search::upper_bound_branchless<K, avx2_search::Ops<Kind>>},
+            {&avx512_search::upper_bound<K, avx512_search::Ops<Kind>>, &avx512_search::find<K, avx512_search::Ops<Kind>>,
+             &avx512_search::upper_bound_branchless<K, avx512_search::Ops<Kind>>},
+#else
+            {&scalar_search::upper_bound<K>, &scalar_search::find<K>, &scalar_search::upper_bound_branchless<K>},
+            {&scalar_search::upper_bound<K>, &scalar_search::find<K>, &scalar_search::upper_bound_branchless<K>},
+            {&scalar_search::upper_bound<K>, &scalar_search::find<K>, &scalar_search::upper_bound_branchless<K>},
+#endif
+#if BPT_ARCH_NEON
+            {&neon_search::upper_bound<K, neon_search::Ops<Kind>>, &neon_search::find<K, neon_search::Ops<Kind>>,
+             &neon_search::upper_bound_branchless<K, neon_search::Ops<Kind>>},
+#else
+            {&scalar_search::upper_bound<K>, &scalar_search::find<K>, &scalar_search::upper_bound_branchless<K>},
+#endif
+        };
+        return kernels;
+    }
+
+    static const SearchKernels<K> &kernels(SimdIsa isa)
+    {
+        return table()[(int)isa];
+    }
+
+    // resolve once per descent and call through the table for every node
+    static const SearchKernels<K> &active()
+    {
+        return table()[(int)active_simd_isa()];
+    }
+
+    static int upper_bound(const K *keys, int n, K key) { return active().upper_bound(keys, n, key); }
+    static int find(const K *keys, int n, K key) { return active().find(keys, n, key); }
+};
+
+template <typename K>
+struct KeySearch<K, KeyKind::Signed32> : DispatchedKeySearch<K, KeyKind::Signed32> {};
+
+template <typename K>
+struct KeySearch<K, KeyKind::Unsigned32> : DispatchedKeySearch<K, KeyKind::Unsigned32> {};
+
+template <typename K>
+struct KeySearch<K, KeyKind::Signed64> : DispatchedKeySearch<K, KeyKind::Signed64> {};
+
+template <typename K>
+struct KeySearch<K, KeyKind::Unsigned64> : DispatchedKeySearch<K, KeyKind::Unsigned64> {};
+
+template <typename K>
+struct KeySearch<K, KeyKind::Float32> : DispatchedKeySearch<K, KeyKind::Float32> {};
+
+template <typename K>
+struct KeySearch<K, KeyKind::Float64> : DispatchedKeySearch<K, KeyKind::Float64> {};
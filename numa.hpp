@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// --- NUMA TOPOLOGY ---
+// just enough NUMA for arenas and worker pinning, straight from sysfs and raw syscalls so there
+// is no libnuma dependency. Without NUMA (one node, not Linux, a container hiding sysfs) every
+// query reports a single node 0 that owns all CPUs, and binding calls are no-ops returning false.
+namespace numa
+{
+    // "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}
+    inline std::vector<int> parse_list(const std::string &list)
+    {
+        std::vector<int> out;
+        size_t i = 0;
+        while (i < list.size())
+        {
+            size_t end = list.find(',', i);
+            if (end == std::string::npos)
+                end = list.size();
+            std::string part = list.substr(i, end - i);
+            int lo, hi;
+            int fields = std::sscanf(part.c_str(), "%d-%d", &lo, &hi);
+            if (fields == 1)
+                out.push_back(lo);
+            else if (fields == 2)
+                for (int v = lo; v <= hi; v++)
+                    out.push_back(v);
+            i = end + 1;
+        }
+        return out;
+    }
+
+    inline std::string read_sysfs(const std::string &path)
+    {
+        std::string text;
+        if (FILE *f = std::fopen(path.c_str(), "r"))
+        {
+            char buf[4096];
+            size_t got = std::fread(buf, 1, sizeof(buf) - 1, f);
+            std::fclose(f);
+            buf[got] = 0;
+            text = buf;
+        }
+        while (!text.empty() && (text.back() == '\n' || text.back() == ' '))
+            text.pop_back();
+        return text;
+    }
+
+    // online nodes, {0} when the system doesn't say
+    inline const std::vector<int> &nodes()
+    {
+        static const std::vector<int> online = [] {
+            std::vector<int> list = parse_list(read_sysfs("/sys/devices/system/node/online"));
+            return list.empty() ? std::vector<int>{0} : list;
+        }();
+        return online;
+    }
+
+    inline int node_count() { return (int)nodes().size(); }
+
+    // CPUs of a node, every online CPU when the node has no cpulist
+    inline std::vector<int> cpus_of_node(int node)
+    {
+        std::vector<int> cpus = parse_list(read_sysfs("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+        if (cpus.empty())
+        {
+            cpus = parse_list(read_sysfs("/sys/devices/system/cpu/online"));
+        }
+        return cpus;
+    }
+
+    // node of the CPU the caller is running on right now, 0 if unknown
+    inline int current_node()
+    {
+#if defined(__linux__) && defined(SYS_getcpu)
+        unsigned cpu = 0, node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+            return (int)node;
+#endif
+        return 0;
+    }
+
+    // pins the calling thread to the CPUs of node, returns false if that isn't possible
+    inline bool pin_thread_to_node(int node)
+    {
+#ifdef __linux__
+        std::vector<int> cpus = cpus_of_node(node);
+        if (cpus.empty())
+            return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+        {
+            if (cpu >= 0 && cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &set);
+        }
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+        (void)node;
+        return false;
+#endif
+    }
+
+    // asks the kernel to place [addr, addr + bytes) on node (MPOL_PREFERRED: falls back to other
+    // nodes instead of failing when node runs out). Must run before the pages are first touched.
+    // false when mbind is unavailable (no NUMA kernel, seccomp), then pages land by first touch
+    inline bool bind_memory(void *addr, size_t bytes, int node)
+    {
+#if defined(__linux__) && defined(SYS_mbind)
+        constexpr int MPOL_PREFERRED_MODE = 1;
+        constexpr int MASK_BITS = 1024;
+        if (node < 0 || node >= MASK_BITS)
+            return false;
+        unsigned long mask[MASK_BITS / (8 * sizeof(unsigned long))] = {};
+        mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+        // maxnode counts one past the last bit the kernel should look at
+        return syscall(SYS_mbind, addr, bytes, MPOL_PREFERRED_MODE, mask, (unsigned long)MASK_BITS + 1, 0) == 0;
+#else
+        (void)addr, (void)bytes, (void)node;
+        return false;
+#endif
+    }
+}
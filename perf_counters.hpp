@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// --- HARDWARE COUNTERS ---
+// one perf_event_open group (user space only) around a benchmark loop. Events the CPU / kernel
+// don't offer are skipped, and when none can be opened (no PMU in a VM, perf_event_paranoid > 2,
+// not Linux) available() is false and the benchmarks just print latencies
+enum class PerfEvent
+{
+    Cycles,
+    Instructions,
+    BranchMisses,
+    L1DMisses,
+    LLCMisses,
+    DTLBMisses,
+    Count
+};
+
+constexpr int PERF_EVENT_COUNT = (int)PerfEvent::Count;
+
+inline const char *perf_event_name(PerfEvent event)
+{
+    switch (event)
+    {
+    case PerfEvent::Cycles:
+        return "cycles";
+    case PerfEvent::Instructions:
+        return "instructions";
+    case PerfEvent::BranchMisses:
+        return "branch-misses";
+    case PerfEvent::L1DMisses:
+        return "L1D-load-misses";
+    case PerfEvent::LLCMisses:
+        return "LLC-load-misses";
+    case PerfEvent::DTLBMisses:
+        return "dTLB-load-misses";
+    default:
+        return "unknown";
+    }
+}
+
+// counts of one start() / stop() window, scaled up if the kernel had to multiplex the group
+struct PerfSample
+{
+    uint64_t value[PERF_EVENT_COUNT] = {};
+    bool valid[PERF_EVENT_COUNT] = {};
+
+    bool has(PerfEvent event) const { return valid[(int)event]; }
+    uint64_t get(PerfEvent event) const { return value[(int)event]; }
+
+    bool any() const
+    {
+        for (bool v : valid)
+        {
+            if (v)
+                return true;
+        }
+        return false;
+    }
+};
+
+class PerfCounterGroup
+{
+    int fds[PERF_EVENT_COUNT];
+    int leader = -1;
+    int slot_of[PERF_EVENT_COUNT]; // position of each event in the group read, -1 = not opened
+    int opened = 0;
+    std::string error;
+
+#ifdef __linux__
+    static bool event_config(PerfEvent event, uint32_t &type, uint64_t &config)
+    {
+        auto cache = [](uint64_t id) {
+            return id | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        switch (event)
+        {
+        case PerfEvent::Cycles:
+            type = PERF_TYPE_HARDWARE, config = PERF_COUNT_HW_CPU_CYCLES;
+            return true;
+        case PerfEvent::Instructions:
+            type = PERF_TYPE_HARDWARE, config = PERF_COUNT_HW_INSTRUCTIONS;
+            return true;
+        case PerfEvent::BranchMisses:
+            type = PERF_TYPE_HARDWARE, config = PERF_COUNT_HW_BRANCH_MISSES;
+            return true;
+        case PerfEvent::L1DMisses:
+            type = PERF_TYPE_HW_CACHE, config = cache(PERF_COUNT_HW_CACHE_L1D);
+            return true;
+        case PerfEvent::LLCMisses:
+            type = PERF_TYPE_HW_CACHE, config = cache(PERF_COUNT_HW_CACHE_LL);
+            return true;
+        case PerfEvent::DTLBMisses:
+            type = PERF_TYPE_HW_CACHE, config = cache(PERF_COUNT_HW_CACHE_DTLB);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    static int open_event(uint32_t type, uint64_t config, int group_fd)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = group_fd == -1; // members follow the leader
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+    }
+#endif
+
+public:
+    PerfCounterGroup()
+    {
+        for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        {
+            fds[i] = -1;
+            slot_of[i] = -1;
+        }
+#ifdef __linux__
+        int first_errno = 0;
+        for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        {
+            uint32_t type;
+            uint64_t config;
+            if (!event_config((PerfEvent)i, type, config))
+                continue;
+            int fd = open_event(type, config, leader);
+            if (fd < 0)
+            {
+                if (!first_errno)
+                    first_errno = errno;
+                continue;
+            }
+            fds[i] = fd;
+            slot_of[i] = opened++;
+            if (leader == -1)
+                leader = fd;
+        }
+        if (!opened)
+        {
+            error = std::string("perf_event_open: ") + std::strerror(first_errno);
+        }
+#else
+        error = "hardware counters need Linux perf_event_open";
+#endif
+    }
+
+    ~PerfCounterGroup()
+    {
+#ifdef __linux__
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+                close(fd);
+        }
+#endif
+    }
+
+    PerfCounterGroup(const PerfCounterGroup &) = delete;
+    PerfCounterGroup &operator=(const PerfCounterGroup &) = delete;
+
+    bool available() const { return opened > 0; }
+    bool has(PerfEvent event) const { return fds[(int)event] >= 0; }
+
+    // why nothing could be opened (empty when available)
+    const std::string &get_error() const { return error; }
+
+    void start()
+    {
+#ifdef __linux__
+        if (!available())
+            return;
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    PerfSample stop()
+    {
+        PerfSample sample;
+#ifdef __linux__
+        if (!available())
+            return sample;
+        ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // { nr, time_enabled, time_running, value[nr] }
+        uint64_t buf[3 + PERF_EVENT_COUNT];
+        if (read(leader, buf, sizeof(buf)) < (ssize_t)(3 * sizeof(uint64_t)) || buf[2] == 0)
+            return sample; // the group never got on the PMU
+        double scale = (double)buf[1] / (double)buf[2];
+        for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        {
+            if (slot_of[i] >= 0 && (uint64_t)slot_of[i] < buf[0])
+            {
+                sample.value[i] = (uint64_t)(buf[3 + slot_of[i]] * scale);
+                sample.valid[i] = true;
+            }
+        }
+#endif
+        return sample;
+    }
+};
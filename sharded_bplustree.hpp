@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "bplustree.hpp"
+#include "numa.hpp"
+
+// --- SHARDED (NUMA) TREE ---
+// range-partitions the key space over K inner BPlusTrees: shard i holds [boundaries[i - 1],
+// boundaries[i]). Every shard has its own Arena bound to one NUMA node (mbind, falling back to
+// first touch), and the shard object itself (lock + tree header) is placed in that arena too,
+// so a thread on the shard's node never leaves its socket for a descent.
+//
+// shards are spread over the online nodes in contiguous runs (neighbouring key ranges share a
+// node). Each shard sits behind its own reader-writer lock, threads on different shards never
+// contend. For socket-local work pin workers with pin_to_shard() / pin_to_node() and give them
+// keys from shards_on_node() (route work by key range, not round robin).
+//
+// with -DBPT_STATS the op counters of a shard are bumped under the shared (read) lock, so
+// concurrent readers race on them: only read them from quiesced trees
+template <typename KeyType, typename ValueType, int InnerM = 256, int LeafM = InnerM,
+          typename Layout = SortedLayout>
+class ShardedBPlusTree
+{
+public:
+    using Tree = BPlusTree<KeyType, ValueType, InnerM, LeafM, Layout>;
+
+private:
+    using Search = KeySearch<KeyType>;
+
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex lock;
+        Tree tree;
+        int node;
+
+        Shard(Arena &arena, int numa_node) : tree(arena), node(numa_node) {}
+    };
+
+    std::vector<KeyType> boundaries;           // num_shards - 1 ascending split keys
+    std::vector<std::unique_ptr<Arena>> arenas; // one per shard, own node
+    std::vector<Shard *> shards;                // each placed in its own arena
+
+    static std::vector<int> default_placement(size_t num_shards)
+    {
+        const std::vector<int> &nodes = numa::nodes();
+        std::vector<int> placement(num_shards);
+        for (size_t i = 0; i < num_shards; i++)
+        {
+            placement[i] = nodes[i * nodes.size() / num_shards];
+        }
+        return placement;
+    }
+
+    void destroy()
+    {
+        for (Shard *shard : shards)
+        {
+            shard->~Shard();
+        }
+        shards.clear();
+        arenas.clear();
+    }
+
+public:
+    // boundaries: the num_shards - 1 ascending keys where a new shard starts. shard_nodes: the NUMA
+    // node for each shard (empty = spread over the online nodes). Throws std::invalid_argument
+    // on unsorted boundaries or a node list of the wrong length
+    explicit ShardedBPlusTree(std::vector<KeyType> split_keys, std::vector<int> shard_nodes = {},
+                              Arena::HugePages huge = Arena::HugePages::Off,
+                              size_t arena_initial = Arena::DEFAULT_INITIAL_SIZE)
+        : boundaries(std::move(split_keys))
+    {
+        for (size_t i = 1; i < boundaries.size(); i++)
+        {
+            if (!(boundaries[i - 1] < boundaries[i]))
+            {
+                throw std::invalid_argument("ShardedBPlusTree boundaries must be strictly increasing");
+            }
+        }
+        size_t num_shards = boundaries.size() + 1;
+        if (shard_nodes.empty())
+        {
+            shard_nodes = default_placement(num_shards);
+        }
+        else if (shard_nodes.size() != num_shards)
+        {
+            throw std::invalid_argument("ShardedBPlusTree needs one NUMA node per shard");
+        }
+
+        try
+        {
+            for (size_t i = 0; i < num_shards; i++)
+            {
+                arenas.emplace_back(new Arena(arena_initial, Arena::UNLIMITED, huge, shard_nodes[i]));
+                void *mem = arenas.back()->allocate(sizeof(Shard));
+                shards.push_back(new (mem) Shard(*arenas.back(), shard_nodes[i]));
+            }
+        }
+        catch (...)
+        {
+            destroy();
+            throw;
+        }
+    }
+
+    ~ShardedBPlusTree()
+    {
+        destroy();
+    }
+
+    ShardedBPlusTree(const ShardedBPlusTree &) = delete;
+    ShardedBPlusTree &operator=(const ShardedBPlusTree &) = delete;
+
+    // num_shards - 1 boundaries cutting [lo, hi] into equal-width ranges (arithmetic keys)
+    static std::vector<KeyType> split_evenly(KeyType lo, KeyType hi, int num_shards)
+    {
+        std::vector<KeyType> out;
+        long double width = ((long double)hi - (long double)lo) / num_shards;
+        for (int i = 1; i < num_shards; i++)
+        {
+            KeyType key = (KeyType)((long double)lo + width * i);
+            if (out.empty() || out.back() < key)
+            {
+                out.push_back(key);
+            }
+        }
+        return out;
+    }
+
+    // boundaries at the quantiles of a key sample, so skewed key sets still get even shards
+    static std::vector<KeyType> split_by_sample(std::vector<KeyType> sample, int num_shards)
+    {
+        std::sort(sample.begin(), sample.end());
+        std::vector<KeyType> out;
+        for (int i = 1; i < num_shards && !sample.empty(); i++)
+        {
+            KeyType key = sample[sample.size() * i / num_shards];
+            if (out.empty() || out.back() < key)
+            {
+                out.push_back(key);
+            }
+        }
+        return out;
+    }
+
+    // --- ROUTING ---
+    int shard_of(KeyType key) const
+    {
+        int n = (int)boundaries.size();
+        if constexpr (Search::has_simd)
+        {
+            return Search::active().upper_bound(boundaries.data(), n, key);
+        }
+        else
+        {
+            return scalar_search::binary_upper_bound(boundaries.data(), n, key);
+        }
+    }
+
+    int shard_count() const { return (int)shards.size(); }
+    int node_of_shard(int shard) const { return shards[shard]->node; }
+
+    std::vector<int> shards_on_node(int node) const
+    {
+        std::vector<int> out;
+        for (int i = 0; i < shard_count(); i++)
+        {
+            if (shards[i]->node == node)
+                out.push_back(i);
+        }
+        return out;
+    }
+
+    // --- WORKER AFFINITY ---
+    // pins the calling thread to the CPUs of the node the shard lives on, false if not possible
+    bool pin_to_shard(int shard) const { return numa::pin_thread_to_node(node_of_shard(shard)); }
+    static bool pin_to_node(int node) { return numa::pin_thread_to_node(node); }
+
+    // true if every shard arena could be mbind'ed (otherwise pages follow first touch)
+    bool numa_bound() const
+    {
+        for (const auto &arena : arenas)
+        {
+            if (!arena->is_numa_bound())
+                return false;
+        }
+        return true;
+    }
+
+    // --- OPERATIONS ---
+    void insert(KeyType key, ValueType value)
+    {
+        Shard &shard = *shards[shard_of(key)];
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        shard.tree.insert(key, value);
+    }
+
+    bool findSIMD(KeyType key, ValueType &val_out) const
+    {
+        Shard &shard = *shards[shard_of(key)];
+        std::shared_lock<std::shared_mutex> guard(shard.lock);
+        return shard.tree.findSIMD(key, val_out);
+    }
+
+    bool remove(KeyType key)
+    {
+        Shard &shard = *shards[shard_of(key)];
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        return shard.tree.remove(key);
+    }
+
+    // calls fn(key, value) for every key in [lo, hi) in key order, one shard lock at a time, so
+    // the scan is consistent per shard but not across shards
+    template <typename Func>
+    size_t scan(KeyType lo, KeyType hi, Func &&fn) const
+    {
+        size_t visited = 0;
+        for (int s = shard_of(lo); s < shard_count(); s++)
+        {
+            if (s > 0 && !(boundaries[s - 1] < hi))
+                break;
+            std::shared_lock<std::shared_mutex> guard(shards[s]->lock);
+            visited += shards[s]->tree.scan(lo, hi, fn);
+        }
+        return visited;
+    }
+
+    size_t size() const
+    {
+        size_t total = 0;
+        for (const Shard *shard : shards)
+        {
+            std::shared_lock<std::shared_mutex> guard(shard->lock);
+            total += shard->tree.size();
+        }
+        return total;
+    }
+
+    // direct access without locking, for the thread that owns a shard (bulk loads, stats)
+    Tree &shard_tree(int shard) { return shards[shard]->tree; }
+    const Tree &shard_tree(int shard) const { return shards[shard]->tree; }
+    Arena &shard_arena(int shard) { return *arenas[shard]; }
+};
@@ -0,0 +1,420 @@
+#pragma once
+
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bplustree.hpp"
+
+// --- READ-ONLY FILE MAPPING ---
+// whole file mapped PROT_READ / MAP_SHARED: pages come straight from the page cache on first
+// touch, nothing is read or copied up front (populate = MAP_POPULATE, fault everything in now)
+class MappedFile
+{
+    void *addr = nullptr;
+    size_t length = 0;
+
+public:
+    MappedFile(const std::string &path, bool populate)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("cannot open " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("cannot map empty / unreadable file " + path);
+        }
+        length = (size_t)st.st_size;
+        int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+        if (populate)
+            flags |= MAP_POPULATE;
+#endif
+        addr = mmap(nullptr, length, PROT_READ, flags, fd, 0);
+        ::close(fd); // the mapping keeps the file referenced
+        if (addr == MAP_FAILED)
+        {
+            throw std::runtime_error("cannot mmap " + path);
+        }
+    }
+
+    ~MappedFile()
+    {
+        munmap(addr, length);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return static_cast<const char *>(addr); }
+    size_t size() const { return length; }
+
+    // hint that [offset, offset + bytes) is about to be read
+    void will_need(size_t offset, size_t bytes) const
+    {
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t start = offset & ~(page - 1);
+        madvise((char *)addr + start, std::min(length - start, bytes + (offset - start)), MADV_WILLNEED);
+    }
+};
+
+// --- STATIC (FROZEN) TREE ---
+// read-only snapshot in S+-tree layout: every node is exactly B keys (default: two cache lines),
+// nodes of a level are stored back to back and the levels follow each other in one arena block,
+// root first. Child i of node k sits at k * (B + 1) + i of the next level, so there are no child
+// pointers and a descent is an index computation plus one vector compare per level.
+//
+// separators are the smallest key of the subtree to their right (key >= separator goes right,
+// same routing as BPlusTree). Slots past the end are padded with key_sentinel<K>().
+//
+// save() writes the same bytes to a file (one header page, then keys and values as laid out in
+// memory); open() maps such a file and serves lookups from it directly, since node positions
+// are computed rather than stored there is nothing to relocate. Files are native-endian and
+// tied to the key / value types and B they were written with.
+template <typename KeyType, typename ValueType, int B = (int)(128 / sizeof(KeyType))>
+class StaticBPlusTree
+{
+    static_assert(has_key_sentinel<KeyType>(), "StaticBPlusTree needs an arithmetic key (sentinel padding)");
+    static_assert(B >= 2, "StaticBPlusTree needs at least two keys per node");
+    static_assert(std::is_trivially_copyable<ValueType>::value, "StaticBPlusTree keeps values in raw arena memory");
+
+    static constexpr int MAX_LEVELS = 32;
+
+    using Search = KeySearch<KeyType>;
+    using Kernels = SearchKernels<KeyType>;
+
+    std::unique_ptr<Arena> arena;     // built in memory
+    std::unique_ptr<MappedFile> file; // or opened from a file
+
+    const KeyType *keys = nullptr;     // all levels, root level first, B keys per node
+    const ValueType *values = nullptr; // parallel to the leaf level
+    const KeyType *leaf_keys = nullptr;
+    size_t key_bytes = 0;   // keys[] incl. padding to 64 bytes
+    size_t value_bytes = 0; // values[] incl. padding to 64 bytes
+
+    size_t n = 0;
+    int num_levels = 0;              // internal levels + the leaf level
+    size_t level_nodes[MAX_LEVELS];  // node count per level, [0] = root level
+    size_t level_offset[MAX_LEVELS]; // first key of each level inside keys[]
+
+    template <typename Iter>
+    void build(Iter first, size_t count, Arena::HugePages huge)
+    {
+        n = count;
+        size_t leaf_blocks = std::max<size_t>(1, (n + B - 1) / B);
+
+        // level sizes bottom-up, then flip so the root is level 0
+        size_t sizes[MAX_LEVELS];
+        int levels = 0;
+        sizes[levels++] = leaf_blocks;
+        while (sizes[levels - 1] > 1)
+        {
+            sizes[levels] = (sizes[levels - 1] + B) / (B + 1);
+            levels++;
+        }
+        num_levels = levels;
+
+        size_t total_nodes = 0;
+        for (int h = 0; h < num_levels; h++)
+        {
+            level_nodes[h] = sizes[num_levels - 1 - h];
+            level_offset[h] = total_nodes * B;
+            total_nodes += level_nodes[h];
+        }
+
+        key_bytes = (total_nodes * B * sizeof(KeyType) + 63) & ~(size_t)63;
+        value_bytes = (leaf_blocks * B * sizeof(ValueType) + 63) & ~(size_t)63;
+        // one chunk sized for the whole snapshot (plus the arena's chunk header)
+        arena.reset(new Arena(key_bytes + value_bytes + 4096, Arena::UNLIMITED, huge));
+        KeyType *key_data = static_cast<KeyType *>(arena->allocate(key_bytes));
+        ValueType *value_data = static_cast<ValueType *>(arena->allocate(value_bytes));
+        keys = key_data;
+        values = value_data;
+
+        // 1. leaf level: the sorted entries, tail padded
+        KeyType *leaves = key_data + level_offset[num_levels - 1];
+        size_t i = 0;
+        for (; i < n; i++, ++first)
+        {
+            auto &&entry = *first;
+            leaves[i] = entry.first;
+            value_data[i] = entry.second;
+        }
+        for (; i < leaf_blocks * B; i++)
+        {
+            leaves[i] = key_sentinel<KeyType>();
+            value_data[i] = ValueType();
+        }
+        leaf_keys = leaves;
+
+        // 2. internal levels: separator j of node k = first key under child k * (B + 1) + j + 1,
+        // i.e. the first key of that child's leftmost leaf block
+        size_t span = 1; // leaf blocks under one node of the level below
+        for (int h = num_levels - 2; h >= 0; h--)
+        {
+            KeyType *level = key_data + level_offset[h];
+            for (size_t k = 0; k < level_nodes[h]; k++)
+            {
+                for (int j = 0; j < B; j++)
+                {
+                    size_t block = (k * (B + 1) + j + 1) * span;
+                    level[k * B + j] = block < leaf_blocks ? leaves[block * B] : key_sentinel<KeyType>();
+                }
+            }
+            span *= B + 1;
+        }
+    }
+
+    // --- FILE FORMAT ---
+    static constexpr char FILE_MAGIC[8] = {'B', 'P', 'T', 'S', 'T', 'A', 'T', '1'};
+    static constexpr uint32_t FILE_VERSION = 1;
+    static constexpr uint32_t ENDIAN_TAG = 0x01020304; // reads back swapped on the other byte order
+    static constexpr size_t FILE_DATA_OFFSET = 4096;   // keys start page aligned
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t endian_tag;
+        uint32_t key_size;
+        uint32_t key_kind; // 0 unsigned integer, 1 signed integer, 2 floating point
+        uint32_t value_size;
+        uint32_t node_keys; // B
+        uint64_t count;
+        uint64_t num_levels;
+        uint64_t level_nodes[MAX_LEVELS];
+        uint64_t level_offset[MAX_LEVELS];
+        uint64_t keys_offset; // from the start of the file
+        uint64_t key_bytes;
+        uint64_t values_offset;
+        uint64_t value_bytes;
+    };
+    static_assert(sizeof(FileHeader) <= FILE_DATA_OFFSET, "header must fit the first page");
+
+    static constexpr uint32_t key_kind()
+    {
+        return std::is_floating_point<KeyType>::value ? 2 : std::is_signed<KeyType>::value ? 1 : 0;
+    }
+
+    // leaf block the descent for key ends in
+    size_t leaf_block(const Kernels &kern, KeyType key) const
+    {
+        size_t k = 0;
+        for (int h = 0; h + 1 < num_levels; h++)
+        {
+            // nodes are full (padded), so the popcount kernel runs without a tail
+            const KeyType *node = keys + level_offset[h] + k * B;
+            size_t child = k * (B + 1) + kern.upper_bound_branchless(node, B, B, key);
+            // a key equal to the sentinel walks past the last real child (build() and open() keep
+            // every level non-empty, so the clamp can't underflow)
+            k = std::min(child, level_nodes[h + 1] - 1);
+            prefetch_t0(keys + level_offset[h + 1] + k * B);
+        }
+        return k;
+    }
+
+    StaticBPlusTree() = default;
+
+public:
+    // entries must be sorted by key without duplicates (e.g. a BPlusTree's own order)
+    template <typename Iter>
+    StaticBPlusTree(Iter first, Iter last, Arena::HugePages huge = Arena::HugePages::Off)
+    {
+        build(first, (size_t)std::distance(first, last), huge);
+    }
+
+    template <int InnerM, int LeafM, typename Layout, typename Filter>
+    explicit StaticBPlusTree(const BPlusTree<KeyType, ValueType, InnerM, LeafM, Layout, Filter> &tree,
+                             Arena::HugePages huge = Arena::HugePages::Off)
+        : StaticBPlusTree(tree.begin(), tree.end(), huge)
+    {
+    }
+
+    StaticBPlusTree(StaticBPlusTree &&) = default;
+    StaticBPlusTree &operator=(StaticBPlusTree &&) = default;
+
+    // same signature as BPlusTree::findSIMD
+    bool findSIMD(KeyType key, ValueType &val_out) const
+    {
+        const Kernels &kern = Search::active();
+        size_t base = leaf_block(kern, key) * B;
+        if (base >= n)
+        {
+            return false;
+        }
+        int idx = kern.find(leaf_keys + base, (int)std::min<size_t>(B, n - base), key);
+        if (idx >= 0)
+        {
+            val_out = values[base + idx];
+            return true;
+        }
+        return false;
+    }
+
+    // position (in key order) of the last key <= key, -1 if every key is greater. Same descent
+    // as findSIMD, the leaf block is ranked instead of probed
+    long predecessor(KeyType key) const
+    {
+        if (n == 0)
+        {
+            return -1;
+        }
+        const Kernels &kern = Search::active();
+        size_t base = leaf_block(kern, key) * B;
+        int le = kern.upper_bound_branchless(leaf_keys + base, (int)std::min<size_t>(B, n - base), B, key);
+        return (long)(base + le) - 1;
+    }
+
+    // entry i in key order, i < size()
+    KeyType key_at(size_t i) const { return leaf_keys[i]; }
+    const ValueType &value_at(size_t i) const { return values[i]; }
+
+    size_t size() const { return n; }
+    int height() const { return num_levels; }
+
+    // keys of every level + the values, excluding the arena's page rounding / the file header
+    size_t memory_bytes() const { return key_bytes + value_bytes; }
+
+    // true when served from a file mapping (open()) rather than memory
+    bool is_mapped() const { return file != nullptr; }
+
+    // writes the snapshot to path (via path + ".tmp" and a rename, so readers never see half a file).
+    // throws std::runtime_error on I/O errors
+    void save(const std::string &path) const
+    {
+        FileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FILE_VERSION;
+        header.endian_tag = ENDIAN_TAG;
+        header.key_size = sizeof(KeyType);
+        header.key_kind = key_kind();
+        header.value_size = sizeof(ValueType);
+        header.node_keys = B;
+        header.count = n;
+        header.num_levels = num_levels;
+        for (int h = 0; h < num_levels; h++)
+        {
+            header.level_nodes[h] = level_nodes[h];
+            header.level_offset[h] = level_offset[h];
+        }
+        header.keys_offset = FILE_DATA_OFFSET;
+        header.key_bytes = key_bytes;
+        header.values_offset = FILE_DATA_OFFSET + key_bytes;
+        header.value_bytes = value_bytes;
+
+        std::string tmp_path = path + ".tmp";
+        FILE *out = std::fopen(tmp_path.c_str(), "wb");
+        if (!out)
+        {
+            throw std::runtime_error("cannot create " + tmp_path);
+        }
+        std::vector<char> page(FILE_DATA_OFFSET, 0);
+        std::memcpy(page.data(), &header, sizeof(header));
+        bool ok = std::fwrite(page.data(), 1, page.size(), out) == page.size() &&
+                  std::fwrite(keys, 1, key_bytes, out) == key_bytes &&
+                  std::fwrite(values, 1, value_bytes, out) == value_bytes;
+        ok = std::fflush(out) == 0 && ok;
+        ok = fsync(fileno(out)) == 0 && ok;
+        ok = std::fclose(out) == 0 && ok;
+        if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0)
+        {
+            std::remove(tmp_path.c_str());
+            throw std::runtime_error("cannot write " + path);
+        }
+    }
+
+    // maps a file written by save() and serves lookups from it, no deserialization: pages are
+    // faulted in as lookups touch them (the internal levels get a MADV_WILLNEED up front).
+    // throws std::runtime_error if the file is unreadable, truncated or was written for other
+    // key / value types or B
+    static StaticBPlusTree open(const std::string &path, bool populate = false)
+    {
+        StaticBPlusTree tree;
+        tree.file.reset(new MappedFile(path, populate));
+        const MappedFile &file = *tree.file;
+
+        if (file.size() < FILE_DATA_OFFSET)
+        {
+            throw std::runtime_error(path + " is not a static tree file (too short)");
+        }
+        FileHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION)
+        {
+            throw std::runtime_error(path + " is not a static tree file (bad magic / version)");
+        }
+        if (header.endian_tag != ENDIAN_TAG || header.key_size != sizeof(KeyType) ||
+            header.key_kind != key_kind() || header.value_size != sizeof(ValueType) || header.node_keys != (uint32_t)B)
+        {
+            throw std::runtime_error(path + " was written for a different key / value type, B or byte order");
+        }
+        // regions are checked by subtraction from the file size, so a corrupt offset can't wrap around
+        if (header.num_levels == 0 || header.num_levels > (uint64_t)MAX_LEVELS ||
+            header.keys_offset % 64 != 0 || header.values_offset % 64 != 0 ||
+            header.keys_offset < FILE_DATA_OFFSET || header.keys_offset > file.size() ||
+            header.key_bytes > file.size() - header.keys_offset ||
+            header.values_offset < FILE_DATA_OFFSET || header.values_offset > file.size() ||
+            header.value_bytes > file.size() - header.values_offset)
+        {
+            throw std::runtime_error(path + " is truncated or corrupt");
+        }
+
+        tree.n = header.count;
+        tree.num_levels = (int)header.num_levels;
+        for (int h = 0; h < tree.num_levels; h++)
+        {
+            tree.level_nodes[h] = header.level_nodes[h];
+            tree.level_offset[h] = header.level_offset[h];
+        }
+
+        // every level non-empty, no more nodes than its parents have children, levels in order
+        // without overlap and inside keys[]. Counts are bounded before they're multiplied
+        const size_t key_slots = header.key_bytes / sizeof(KeyType);
+        size_t level_end = 0;
+        for (int h = 0; h < tree.num_levels; h++)
+        {
+            size_t nodes = tree.level_nodes[h];
+            size_t offset = tree.level_offset[h];
+            if (nodes == 0 || offset < level_end || offset > key_slots || nodes > (key_slots - offset) / B ||
+                (h > 0 && (nodes - 1) / (B + 1) >= tree.level_nodes[h - 1]))
+            {
+                throw std::runtime_error(path + " is truncated or corrupt");
+            }
+            level_end = offset + nodes * B;
+        }
+        size_t leaf_slots = tree.level_nodes[tree.num_levels - 1] * B;
+        if (tree.n > leaf_slots || leaf_slots > header.value_bytes / sizeof(ValueType))
+        {
+            throw std::runtime_error(path + " is truncated or corrupt");
+        }
+
+        tree.keys = reinterpret_cast<const KeyType *>(file.data() + header.keys_offset);
+        tree.values = reinterpret_cast<const ValueType *>(file.data() + header.values_offset);
+        tree.leaf_keys = tree.keys + tree.level_offset[tree.num_levels - 1];
+        tree.key_bytes = header.key_bytes;
+        tree.value_bytes = header.value_bytes;
+
+        // every lookup walks the internal levels, get them in while the caller gets going
+        file.will_need(header.keys_offset, tree.level_offset[tree.num_levels - 1] * sizeof(KeyType));
+        return tree;
+    }
+};
+
+// read-only snapshot of a tree's current contents
+template <typename KeyType, typename ValueType, int InnerM, int LeafM, typename Layout, typename Filter>
+StaticBPlusTree<KeyType, ValueType> freeze(const BPlusTree<KeyType, ValueType, InnerM, LeafM, Layout, Filter> &tree,
+                                           Arena::HugePages huge = Arena::HugePages::Off)
+{
+    return StaticBPlusTree<KeyType, ValueType>(tree, huge);
+}
@@ -0,0 +1,550 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "bplustree.hpp"
+
+// --- STRING KEYS ---
+// B+ tree for variable-length byte-string keys (URLs, paths). Every node is one slotted page of
+// PageSize bytes from the arena:
+//
+//   [header][heads: count x u32][slots: count x {offset, length}] ... free ... [heap]
+//
+// the heap grows down from the end of the page and holds the two fence keys plus, per entry,
+// the key bytes after the page prefix followed by the value (leaf) or child pointer (inner).
+// - prefix truncation: every key between a page's fences shares the fences' common prefix,
+//   which is kept once (the start of the lower fence) and cut from each key in the page
+// - key heads: the first 4 bytes after the prefix, big-endian in a u32, so the uint32 SIMD
+//   kernel narrows a search to the slots with an equal head before any memcmp
+// - separators: a split pushes up the shortest key between the two halves (common prefix of
+//   the keys around the split + one byte), not a full key
+//
+// keys compare as unsigned bytes (std::string's order). Inner slot i routes keys in
+// [separator i - 1, separator i) to its child, keys >= the last separator go to upper_child.
+// remove() does not merge pages, a page that runs empty stays in the tree until clear()
+template <typename ValueType, size_t PageSize = 4096>
+class StringBPlusTree
+{
+    static_assert(PageSize >= 1024 && PageSize <= 65536, "PageSize must fit the 16-bit slot offsets");
+    static_assert(std::is_trivially_copyable<ValueType>::value, "StringBPlusTree keeps values in raw page memory");
+
+public:
+    // longest key accepted: leaves room for two fences and two entries in each half of a split
+    static constexpr size_t MAX_KEY_LEN = PageSize / 16;
+
+private:
+    struct Page
+    {
+        bool is_leaf;
+        bool has_upper;      // false = upper fence is +infinity
+        uint16_t count;
+        uint16_t heap_start; // heap is [heap_start, PageSize)
+        uint16_t dead_bytes; // heap bytes of removed entries, reclaimed by compaction
+        uint16_t prefix_len; // shared by every key in the page = first bytes of the lower fence
+        uint16_t lower_offset, lower_len; // inclusive lower fence (empty = -infinity)
+        uint16_t upper_offset, upper_len; // exclusive upper fence
+        Page *next;          // leaf chain
+        Page *upper_child;   // inner: child for keys >= the last separator
+    };
+
+    struct Slot
+    {
+        uint16_t offset; // key bytes (after the prefix), payload right behind them
+        uint16_t len;
+    };
+
+    static constexpr size_t HEADER = (sizeof(Page) + 15) & ~(size_t)15;
+    static constexpr size_t ENTRY_OVERHEAD = sizeof(uint32_t) + sizeof(Slot); // head + slot
+
+    using HeadSearch = KeySearch<uint32_t>;
+
+    std::unique_ptr<Arena> owned_arena;
+    Arena *arena;
+
+    Page *root;
+    Page *head_leaf;
+    size_t num_entries = 0;
+    size_t num_pages = 0;
+    int num_levels = 1;
+
+    // split / compaction staging, one page
+    std::unique_ptr<char[]> scratch_memory;
+    Page *scratch;
+
+    // --- PAGE ACCESS ---
+    static char *bytes(Page *p) { return reinterpret_cast<char *>(p); }
+    static const char *bytes(const Page *p) { return reinterpret_cast<const char *>(p); }
+    static uint32_t *heads(Page *p) { return reinterpret_cast<uint32_t *>(bytes(p) + HEADER); }
+    static const uint32_t *heads(const Page *p) { return reinterpret_cast<const uint32_t *>(bytes(p) + HEADER); }
+    static Slot *slots(Page *p) { return reinterpret_cast<Slot *>(bytes(p) + HEADER + sizeof(uint32_t) * p->count); }
+    static const Slot *slots(const Page *p)
+    {
+        return reinterpret_cast<const Slot *>(bytes(p) + HEADER + sizeof(uint32_t) * p->count);
+    }
+
+    static const char *key_at(const Page *p, int i) { return bytes(p) + slots(p)[i].offset; }
+    static size_t key_len_at(const Page *p, int i) { return slots(p)[i].len; }
+    static const char *payload_at(const Page *p, int i) { return key_at(p, i) + key_len_at(p, i); }
+    static char *payload_at(Page *p, int i) { return bytes(p) + slots(p)[i].offset + slots(p)[i].len; }
+
+    static size_t payload_size(const Page *p) { return p->is_leaf ? sizeof(ValueType) : sizeof(Page *); }
+
+    static size_t free_space(const Page *p) { return p->heap_start - (HEADER + ENTRY_OVERHEAD * p->count); }
+
+    static Page *child_at(const Page *p, int i)
+    {
+        if (i == p->count)
+            return p->upper_child;
+        Page *child;
+        std::memcpy(&child, payload_at(p, i), sizeof(child));
+        return child;
+    }
+
+    static void set_child(Page *p, int i, Page *child)
+    {
+        if (i == p->count)
+            p->upper_child = child;
+        else
+            std::memcpy(payload_at(p, i), &child, sizeof(child));
+    }
+
+    static std::string lower_fence(const Page *p) { return std::string(bytes(p) + p->lower_offset, p->lower_len); }
+    static std::string upper_fence(const Page *p) { return std::string(bytes(p) + p->upper_offset, p->upper_len); }
+
+    // page prefix + the stored tail
+    static std::string full_key(const Page *p, int i)
+    {
+        std::string key(bytes(p) + p->lower_offset, p->prefix_len);
+        key.append(key_at(p, i), key_len_at(p, i));
+        return key;
+    }
+
+    // first 4 bytes, big-endian so that integer order = byte order (short keys pad with 0)
+    static uint32_t make_head(const char *key, size_t len)
+    {
+        uint32_t head = 0;
+        for (size_t i = 0; i < 4; i++)
+        {
+            head = (head << 8) | (i < len ? (uint8_t)key[i] : 0);
+        }
+        return head;
+    }
+
+    static int compare(const char *a, size_t a_len, const char *b, size_t b_len)
+    {
+        int c = std::memcmp(a, b, std::min(a_len, b_len));
+        if (c != 0)
+            return c;
+        return a_len < b_len ? -1 : (a_len > b_len ? 1 : 0);
+    }
+
+    static size_t common_prefix(const std::string &a, const std::string &b)
+    {
+        size_t n = std::min(a.size(), b.size());
+        size_t i = 0;
+        while (i < n && a[i] == b[i])
+            i++;
+        return i;
+    }
+
+    // --- PAGE SEARCH ---
+    // first slot whose key is >= the given tail (already stripped of the page prefix)
+    static int lower_bound(const Page *p, const char *key, size_t len, bool &equal)
+    {
+        const SearchKernels<uint32_t> &kern = HeadSearch::active();
+        const uint32_t *h = heads(p);
+        uint32_t head = make_head(key, len);
+        int n = p->count;
+
+        // [lo, hi) = the slots with an equal head
+        int lo = head == 0 ? 0 : kern.upper_bound(h, n, head - 1);
+        int hi = lo + kern.upper_bound(h + lo, n - lo, head);
+        int end = hi;
+        while (lo < hi)
+        {
+            int mid = lo + (hi - lo) / 2;
+            if (compare(key_at(p, mid), key_len_at(p, mid), key, len) < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        equal = lo < end && compare(key_at(p, lo), key_len_at(p, lo), key, len) == 0;
+        return lo;
+    }
+
+    // inner: child index for key (first separator > key, count = upper_child)
+    static int child_index(const Page *p, const char *key, size_t len)
+    {
+        bool equal;
+        int i = lower_bound(p, key + p->prefix_len, len - p->prefix_len, equal);
+        return equal ? i + 1 : i;
+    }
+
+    // --- PAGE MUTATION ---
+    void init_page(Page *p, bool leaf, const std::string *lower, const std::string *upper)
+    {
+        p->is_leaf = leaf;
+        p->has_upper = upper != nullptr;
+        p->count = 0;
+        p->heap_start = (uint16_t)PageSize;
+        p->dead_bytes = 0;
+        p->next = nullptr;
+        p->upper_child = nullptr;
+        p->lower_len = 0;
+        p->upper_len = 0;
+        p->lower_offset = p->upper_offset = (uint16_t)PageSize;
+        if (lower)
+        {
+            p->heap_start -= (uint16_t)lower->size();
+            std::memcpy(bytes(p) + p->heap_start, lower->data(), lower->size());
+            p->lower_offset = p->heap_start;
+            p->lower_len = (uint16_t)lower->size();
+        }
+        if (upper)
+        {
+            p->heap_start -= (uint16_t)upper->size();
+            std::memcpy(bytes(p) + p->heap_start, upper->data(), upper->size());
+            p->upper_offset = p->heap_start;
+            p->upper_len = (uint16_t)upper->size();
+        }
+        p->prefix_len = (uint16_t)(lower && upper ? common_prefix(*lower, *upper) : 0);
+    }
+
+    Page *new_page(bool leaf, const std::string *lower, const std::string *upper)
+    {
+        Page *p = static_cast<Page *>(arena->allocate(PageSize));
+        init_page(p, leaf, lower, upper);
+        num_pages++;
+        return p;
+    }
+
+    // opens slot pos and copies the tail + payload into the heap, caller checked free_space
+    static void insert_entry(Page *p, int pos, const char *key, size_t len, const void *payload)
+    {
+        size_t psize = payload_size(p);
+        p->heap_start -= (uint16_t)(len + psize);
+        std::memcpy(bytes(p) + p->heap_start, key, len);
+        std::memcpy(bytes(p) + p->heap_start + len, payload, psize);
+
+        // heads grow by one, which moves the whole slot array up 4 bytes (the tail of it 8)
+        int n = p->count;
+        uint32_t *h = heads(p);
+        Slot *old_slots = slots(p);
+        Slot *new_slots = reinterpret_cast<Slot *>(h + n + 1);
+        std::memmove(new_slots + pos + 1, old_slots + pos, sizeof(Slot) * (n - pos));
+        std::memmove(new_slots, old_slots, sizeof(Slot) * pos);
+        std::memmove(h + pos + 1, h + pos, sizeof(uint32_t) * (n - pos));
+
+        h[pos] = make_head(key, len);
+        new_slots[pos] = Slot{p->heap_start, (uint16_t)len};
+        p->count++;
+    }
+
+    static void erase_entry(Page *p, int pos)
+    {
+        int n = p->count;
+        uint32_t *h = heads(p);
+        Slot *old_slots = slots(p);
+        p->dead_bytes += (uint16_t)(old_slots[pos].len + payload_size(p));
+
+        std::memmove(h + pos, h + pos + 1, sizeof(uint32_t) * (n - pos - 1));
+        Slot *new_slots = reinterpret_cast<Slot *>(h + n - 1);
+        std::memmove(new_slots, old_slots, sizeof(Slot) * pos);
+        std::memmove(new_slots + pos, old_slots + pos + 1, sizeof(Slot) * (n - pos - 1));
+        p->count--;
+    }
+
+    // appends entry i of src (re-cut to dst's prefix) to dst
+    static void copy_entry(Page *dst, const Page *src, int i)
+    {
+        // dst's prefix is at least as long as src's (its fences are inside src's)
+        size_t cut = dst->prefix_len - src->prefix_len;
+        insert_entry(dst, dst->count, key_at(src, i) + cut, key_len_at(src, i) - cut, payload_at(src, i));
+    }
+
+    // rebuilds p in place without the dead heap bytes
+    void compact(Page *p)
+    {
+        std::string lower = lower_fence(p), upper = upper_fence(p);
+        init_page(scratch, p->is_leaf, p->lower_len ? &lower : nullptr, p->has_upper ? &upper : nullptr);
+        for (int i = 0; i < p->count; i++)
+        {
+            copy_entry(scratch, p, i);
+        }
+        scratch->next = p->next;
+        scratch->upper_child = p->upper_child;
+        std::memcpy(p, scratch, PageSize);
+    }
+
+    bool make_room(Page *p, size_t needed)
+    {
+        if (free_space(p) >= needed)
+            return true;
+        if (free_space(p) + p->dead_bytes >= needed)
+        {
+            compact(p);
+            return true;
+        }
+        return false;
+    }
+
+    // slot where the bytes of p's entries are split in half (both sides keep at least one)
+    static int split_point(const Page *p)
+    {
+        size_t total = 0;
+        for (int i = 0; i < p->count; i++)
+            total += key_len_at(p, i) + payload_size(p) + ENTRY_OVERHEAD;
+        size_t acc = 0;
+        int m = 0;
+        while (m < p->count - 1 && acc < total / 2)
+        {
+            acc += key_len_at(p, m) + payload_size(p) + ENTRY_OVERHEAD;
+            m++;
+        }
+        return std::max(1, m);
+    }
+
+    // --- SPLITTING LOGIC ---
+    // p keeps [lower, separator), right gets [separator, upper). Leaf separators are the shortest
+    // prefix of the right half's first key that is still above the left half's last key
+    void split_leaf(Page *p, std::string &separator, Page *&right)
+    {
+        int m = split_point(p);
+        std::string last_left = full_key(p, m - 1);
+        std::string first_right = full_key(p, m);
+        separator = first_right.substr(0, common_prefix(last_left, first_right) + 1);
+        split_page(p, m, m, separator, right);
+    }
+
+    // separator m moves up, its child becomes the left half's upper_child
+    void split_inner(Page *p, std::string &separator, Page *&right)
+    {
+        int m = split_point(p);
+        separator = full_key(p, m);
+        split_page(p, m, m + 1, separator, right);
+    }
+
+    // left = entries [0, left_end), right = [right_begin, count)
+    void split_page(Page *p, int left_end, int right_begin, const std::string &separator, Page *&right)
+    {
+        std::string lower = lower_fence(p), upper = upper_fence(p);
+        const std::string *lower_ptr = p->lower_len ? &lower : nullptr;
+        const std::string *upper_ptr = p->has_upper ? &upper : nullptr;
+
+        right = new_page(p->is_leaf, &separator, upper_ptr);
+        for (int i = right_begin; i < p->count; i++)
+            copy_entry(right, p, i);
+        right->upper_child = p->upper_child;
+        right->next = p->next;
+
+        init_page(scratch, p->is_leaf, lower_ptr, &separator);
+        for (int i = 0; i < left_end; i++)
+            copy_entry(scratch, p, i);
+        scratch->next = p->is_leaf ? right : nullptr;
+        scratch->upper_child = p->is_leaf ? nullptr : child_at(p, left_end);
+        std::memcpy(p, scratch, PageSize);
+    }
+
+    // --- INSERTION ---
+    // returns true when p split: p keeps the keys below separator, right the rest
+    bool insert_recursive(Page *p, const std::string &key, const ValueType &value, std::string &separator, Page *&right)
+    {
+        if (p->is_leaf)
+        {
+            const char *tail = key.data() + p->prefix_len;
+            size_t tail_len = key.size() - p->prefix_len;
+            bool equal;
+            int pos = lower_bound(p, tail, tail_len, equal);
+            if (equal)
+            {
+                std::memcpy(payload_at(p, pos), &value, sizeof(ValueType));
+                return false;
+            }
+
+            bool split = false;
+            Page *target = p;
+            if (!make_room(p, tail_len + sizeof(ValueType) + ENTRY_OVERHEAD))
+            {
+                split_leaf(p, separator, right);
+                split = true;
+                if (compare(key.data(), key.size(), separator.data(), separator.size()) >= 0)
+                    target = right;
+                tail = key.data() + target->prefix_len;
+                tail_len = key.size() - target->prefix_len;
+                pos = lower_bound(target, tail, tail_len, equal);
+            }
+            insert_entry(target, pos, tail, tail_len, &value);
+            num_entries++;
+            return split;
+        }
+
+        int idx = child_index(p, key.data(), key.size());
+        std::string child_separator;
+        Page *child_right = nullptr;
+        if (!insert_recursive(child_at(p, idx), key, value, child_separator, child_right))
+            return false;
+
+        // the child keeps [.., child_separator) and is re-filed under the new separator, the
+        // slot that pointed to it now covers the new right half
+        Page *child = child_at(p, idx);
+        set_child(p, idx, child_right);
+
+        bool split = false;
+        Page *target = p;
+        if (!make_room(p, child_separator.size() - p->prefix_len + sizeof(Page *) + ENTRY_OVERHEAD))
+        {
+            split_inner(p, separator, right);
+            split = true;
+            if (compare(child_separator.data(), child_separator.size(), separator.data(), separator.size()) > 0)
+                target = right;
+        }
+        const char *tail = child_separator.data() + target->prefix_len;
+        size_t tail_len = child_separator.size() - target->prefix_len;
+        bool equal;
+        int pos = lower_bound(target, tail, tail_len, equal);
+        insert_entry(target, pos, tail, tail_len, &child);
+        return split;
+    }
+
+    Page *find_leaf(const std::string &key) const
+    {
+        Page *p = root;
+        while (!p->is_leaf)
+        {
+            Page *next = child_at(p, child_index(p, key.data(), key.size()));
+            prefetch_t0(next);
+            prefetch_t0(bytes(next) + 64);
+            p = next;
+        }
+        return p;
+    }
+
+    void init_empty()
+    {
+        num_entries = 0;
+        num_pages = 0;
+        num_levels = 1;
+        root = new_page(true, nullptr, nullptr);
+        head_leaf = root;
+    }
+
+public:
+    StringBPlusTree()
+        : owned_arena(new Arena()), arena(owned_arena.get()),
+          scratch_memory(new char[PageSize + 64]),
+          scratch(reinterpret_cast<Page *>(((uintptr_t)scratch_memory.get() + 63) & ~(uintptr_t)63))
+    {
+        init_empty();
+    }
+
+    // pages come from a caller-managed arena that must outlive the tree
+    explicit StringBPlusTree(Arena &shared_arena)
+        : arena(&shared_arena), scratch_memory(new char[PageSize + 64]),
+          scratch(reinterpret_cast<Page *>(((uintptr_t)scratch_memory.get() + 63) & ~(uintptr_t)63))
+    {
+        init_empty();
+    }
+
+    StringBPlusTree(const StringBPlusTree &) = delete;
+    StringBPlusTree &operator=(const StringBPlusTree &) = delete;
+
+    // inserts or overwrites. throws std::length_error for keys longer than MAX_KEY_LEN
+    void insert(const std::string &key, const ValueType &value)
+    {
+        if (key.size() > MAX_KEY_LEN)
+        {
+            throw std::length_error("StringBPlusTree key longer than MAX_KEY_LEN");
+        }
+
+        std::string separator;
+        Page *right = nullptr;
+        if (insert_recursive(root, key, value, separator, right))
+        {
+            Page *new_root = new_page(false, nullptr, nullptr);
+            insert_entry(new_root, 0, separator.data(), separator.size(), &root);
+            new_root->upper_child = right;
+            root = new_root;
+            num_levels++;
+        }
+    }
+
+    // prefix-truncated, head-filtered descent (the head compare runs on the SIMD kernels)
+    bool findSIMD(const std::string &key, ValueType &val_out) const
+    {
+        const Page *leaf = find_leaf(key);
+        if (key.size() < leaf->prefix_len)
+            return false;
+        bool equal;
+        int pos = lower_bound(leaf, key.data() + leaf->prefix_len, key.size() - leaf->prefix_len, equal);
+        if (!equal)
+            return false;
+        std::memcpy(&val_out, payload_at(leaf, pos), sizeof(ValueType));
+        return true;
+    }
+
+    // returns false if the key was not present (pages are not merged)
+    bool remove(const std::string &key)
+    {
+        Page *leaf = find_leaf(key);
+        if (key.size() < leaf->prefix_len)
+            return false;
+        bool equal;
+        int pos = lower_bound(leaf, key.data() + leaf->prefix_len, key.size() - leaf->prefix_len, equal);
+        if (!equal)
+            return false;
+        erase_entry(leaf, pos);
+        num_entries--;
+        return true;
+    }
+
+    // calls fn(const std::string &key, const ValueType &value) for every key in [lo, hi),
+    // returns how many
+    template <typename Func>
+    size_t scan(const std::string &lo, const std::string &hi, Func &&fn) const
+    {
+        const Page *leaf = find_leaf(lo);
+        bool equal;
+        size_t skip = std::min<size_t>(lo.size(), leaf->prefix_len);
+        int i = lower_bound(leaf, lo.data() + skip, lo.size() - skip, equal);
+        size_t visited = 0;
+        std::string key;
+        ValueType value;
+        for (; leaf; leaf = leaf->next, i = 0)
+        {
+            key.assign(bytes(leaf) + leaf->lower_offset, leaf->prefix_len);
+            for (; i < leaf->count; i++)
+            {
+                key.resize(leaf->prefix_len);
+                key.append(key_at(leaf, i), key_len_at(leaf, i));
+                if (!(key < hi))
+                    return visited;
+                std::memcpy(&value, payload_at(leaf, i), sizeof(ValueType));
+                fn(key, value);
+                visited++;
+            }
+        }
+        return visited;
+    }
+
+    void clear()
+    {
+        if (owned_arena)
+        {
+            owned_arena->reset();
+        }
+        init_empty();
+    }
+
+    size_t size() const { return num_entries; }
+    bool empty() const { return num_entries == 0; }
+    int height() const { return num_levels; }
+    size_t page_count() const { return num_pages; }
+    size_t memory_bytes() const { return num_pages * PageSize; }
+    static constexpr size_t page_bytes() { return PageSize; }
+};
@@ -0,0 +1,155 @@
+#include "../static_bplustree.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// build: g++ -std=c++17 -O1 -fsanitize=address,undefined tests/test_static_open.cpp -o test_static_open
+// StaticBPlusTree::open on truncated / corrupted files must throw std::runtime_error instead of
+// handing out a tree that reads outside the mapping
+
+int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << endl; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+using Tree = StaticBPlusTree<int, int>;
+
+// byte offsets of the header fields save() writes (see StaticBPlusTree::FileHeader)
+const size_t OFF_COUNT = 32;
+const size_t OFF_LEVEL_NODES = 48;
+const size_t OFF_LEVEL_OFFSET = OFF_LEVEL_NODES + 32 * 8;
+const size_t OFF_KEYS_OFFSET = OFF_LEVEL_OFFSET + 32 * 8;
+const size_t OFF_KEY_BYTES = OFF_KEYS_OFFSET + 8;
+const size_t OFF_VALUES_OFFSET = OFF_KEY_BYTES + 8;
+const size_t OFF_VALUE_BYTES = OFF_VALUES_OFFSET + 8;
+
+vector<char> read_file(const string& path) {
+    ifstream in(path, ios::binary);
+    return vector<char>((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+
+void write_file(const string& path, const vector<char>& bytes, size_t length) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(bytes.data(), (streamsize)length);
+}
+
+uint64_t get_u64(const vector<char>& bytes, size_t off) {
+    uint64_t v;
+    memcpy(&v, bytes.data() + off, sizeof(v));
+    return v;
+}
+
+void set_u64(vector<char>& bytes, size_t off, uint64_t v) {
+    memcpy(bytes.data() + off, &v, sizeof(v));
+}
+
+bool open_throws(const string& path) {
+    try {
+        Tree::open(path);
+    } catch (const runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+// one corrupted copy of the good file, expects open() to reject it
+void check_rejected(const char* what, const vector<char>& good, const string& path,
+                    const function<void(vector<char>&)>& corrupt) {
+    vector<char> bytes = good;
+    corrupt(bytes);
+    write_file(path, bytes, bytes.size());
+    if (!open_throws(path)) {
+        cerr << "  corrupt file accepted: " << what << endl;
+        failures++;
+    }
+}
+
+int main() {
+    const string path = "/tmp/test_static_open.bpt";
+    const string bad_path = path + ".bad";
+
+    vector<pair<int, int>> entries;
+    for (int i = 0; i < 100000; i++) entries.push_back({i * 3, i});
+    Tree tree(entries.begin(), entries.end());
+    CHECK(tree.height() >= 3);
+    tree.save(path);
+
+    // the untouched file opens and serves lookups
+    {
+        Tree mapped = Tree::open(path);
+        CHECK(mapped.size() == entries.size());
+        int val = -1;
+        CHECK(mapped.findSIMD(300, val) && val == 100);
+        CHECK(!mapped.findSIMD(301, val));
+    }
+
+    const vector<char> good = read_file(path);
+    const uint64_t levels = tree.height();
+    const uint64_t leaf_level = levels - 1;
+
+    // truncated: inside the header page, inside the keys, inside the values
+    for (size_t length : {(size_t)100, (size_t)5000, good.size() / 2, good.size() - 64}) {
+        write_file(bad_path, good, length);
+        CHECK(open_throws(bad_path));
+    }
+
+    check_rejected("empty root level", good, bad_path,
+                   [](vector<char>& b) { set_u64(b, OFF_LEVEL_NODES, 0); });
+    check_rejected("empty internal level", good, bad_path,
+                   [](vector<char>& b) { set_u64(b, OFF_LEVEL_NODES + 8, 0); });
+    check_rejected("empty leaf level", good, bad_path, [&](vector<char>& b) {
+        set_u64(b, OFF_LEVEL_NODES + 8 * leaf_level, 0);
+        set_u64(b, OFF_COUNT, 0);
+    });
+    check_rejected("more nodes than the parents have children", good, bad_path,
+                   [](vector<char>& b) { set_u64(b, OFF_LEVEL_NODES + 8, 34); });
+    check_rejected("overlapping levels", good, bad_path,
+                   [](vector<char>& b) { set_u64(b, OFF_LEVEL_OFFSET + 8, 0); });
+    check_rejected("level past keys[]", good, bad_path, [&](vector<char>& b) {
+        set_u64(b, OFF_LEVEL_OFFSET + 8 * leaf_level, get_u64(b, OFF_KEY_BYTES) / sizeof(int));
+    });
+    check_rejected("node count overflowing the multiply", good, bad_path, [&](vector<char>& b) {
+        set_u64(b, OFF_LEVEL_NODES + 8 * leaf_level, UINT64_MAX / 32 + 2);
+    });
+    check_rejected("count past the leaves", good, bad_path, [](vector<char>& b) {
+        set_u64(b, OFF_COUNT, get_u64(b, OFF_COUNT) + 1000000);
+    });
+    check_rejected("keys offset wrapping around", good, bad_path, [](vector<char>& b) {
+        set_u64(b, OFF_KEYS_OFFSET, UINT64_MAX - 63);
+    });
+    check_rejected("key bytes wrapping around", good, bad_path, [](vector<char>& b) {
+        set_u64(b, OFF_KEY_BYTES, UINT64_MAX - 4095);
+    });
+    check_rejected("values offset wrapping around", good, bad_path, [](vector<char>& b) {
+        set_u64(b, OFF_VALUES_OFFSET, UINT64_MAX - 63);
+    });
+    check_rejected("value bytes wrapping around", good, bad_path, [](vector<char>& b) {
+        set_u64(b, OFF_VALUE_BYTES, UINT64_MAX - 4095);
+    });
+    check_rejected("keys inside the header page", good, bad_path,
+                   [](vector<char>& b) { set_u64(b, OFF_KEYS_OFFSET, 64); });
+    check_rejected("no levels", good, bad_path, [](vector<char>& b) { set_u64(b, 40, 0); });
+
+    remove(path.c_str());
+    remove(bad_path.c_str());
+
+    if (failures) {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "test_static_open: ok" << endl;
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "../bplustree.hpp"
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// build: g++ -std=c++17 -O1 -DBPT_STATS -fsanitize=address,undefined tests/test_top_cache.cpp -o test_top_cache
+// bulk_load with the top-levels cache on: empty and repeated loads must not leave the mirror
+// pointing into the freed nodes of the previous contents. A mirror that stops above the bottom
+// internal level is patched, not rebuilt, when a node right below it splits or merges
+
+int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << endl; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+template<typename Tree>
+void check_contents(Tree& tree, const map<int, int>& expected, mt19937& gen) {
+    CHECK(tree.size() == expected.size());
+    for (const auto& kv : expected) {
+        int val = -1;
+        CHECK(tree.findSIMD(kv.first, val) && val == kv.second);
+    }
+    vector<int> keys(2000);
+    for (int& k : keys) k = (int)(gen() % 400000);
+    vector<int> out(keys.size());
+    vector<uint8_t> found(keys.size());
+    tree.findBatch(keys.data(), keys.size(), out.data(), found.data());
+    for (size_t i = 0; i < keys.size(); i++) {
+        auto it = expected.find(keys[i]);
+        CHECK((it != expected.end()) == (bool)found[i]);
+        if (found[i] && it != expected.end()) CHECK(out[i] == it->second);
+        int val;
+        CHECK(tree.findSIMD(keys[i], val) == (it != expected.end()));
+    }
+}
+
+template<typename Tree>
+void test_bulk_load_with_cache() {
+    mt19937 gen(29);
+    Tree tree;
+    map<int, int> expected;
+    for (int i = 0; i < 200000; i++) {
+        int k = (int)(gen() % 400000);
+        tree.insert(k, i);
+        expected[k] = i;
+    }
+    tree.enable_top_cache();
+    CHECK(tree.top_cache_levels() > 0);
+
+    // empty range: the old nodes are freed, lookups must not route through the old mirror
+    vector<pair<int, int>> empty;
+    tree.bulk_load(empty.begin(), empty.end());
+    expected.clear();
+    check_contents(tree, expected, gen);
+    int val;
+    CHECK(!tree.findSIMD(5, val));
+
+    // repeated loads of different sizes, sorted and unsorted input
+    for (int round = 0; round < 6; round++) {
+        size_t n = round % 2 ? 50000 * round : 3 * round;
+        vector<pair<int, int>> entries;
+        expected.clear();
+        for (size_t i = 0; i < n; i++) {
+            int k = (int)(gen() % 400000);
+            entries.push_back({k, (int)i});
+            expected[k] = (int)i;
+        }
+        tree.bulk_load(entries.begin(), entries.end(), round % 3 == 0 ? 1.0 : 0.7);
+        check_contents(tree, expected, gen);
+
+        // mutations after the load keep the mirror current
+        for (int i = 0; i < 20000; i++) {
+            int k = (int)(gen() % 400000);
+            if (gen() % 3) {
+                tree.insert(k, i);
+                expected[k] = i;
+            } else {
+                CHECK(tree.remove(k) == (expected.erase(k) == 1));
+            }
+        }
+        check_contents(tree, expected, gen);
+    }
+    tree.bulk_load(empty.begin(), empty.end());
+    expected.clear();
+    check_contents(tree, expected, gen);
+}
+
+// budget for a few levels only, so splits / merges happen below, right below and inside the mirror
+template<typename Tree>
+void test_partial_mirror(size_t budget) {
+    mt19937 gen(30);
+    Tree tree;
+    map<int, int> expected;
+    for (int i = 0; i < 100000; i++) {
+        int k = (int)(gen() % 400000);
+        tree.insert(k, i);
+        expected[k] = i;
+    }
+    tree.enable_top_cache(budget);
+    CHECK(tree.top_cache_levels() > 0);
+    CHECK(tree.top_cache_levels() < tree.height() - 1);
+    tree.reset_op_counters();
+
+    for (int round = 0; round < 8; round++) {
+        // growing rounds split, shrinking ones borrow and merge
+        bool grow = round % 2 == 0;
+        for (int i = 0; i < 40000; i++) {
+            int k = (int)(gen() % 400000);
+            if (gen() % 4 == 0 ? !grow : grow) {
+                tree.insert(k, i);
+                expected[k] = i;
+            } else {
+                CHECK(tree.remove(k) == (expected.erase(k) == 1));
+            }
+        }
+        check_contents(tree, expected, gen);
+    }
+    CHECK(tree.top_cache_levels() > 0);
+
+#ifdef BPT_STATS
+    // internal splits mostly happen below the mirror, only the few inside it rebuild
+    const BPlusTreeCounters& ops = tree.op_counters();
+    CHECK(ops.inner_splits > 0);
+    CHECK(ops.top_cache_rebuilds * 10 < ops.inner_splits);
+#endif
+}
+
+int main() {
+    test_bulk_load_with_cache<BPlusTree<int, int>>();
+    test_bulk_load_with_cache<BPlusTree<int, int, 4, 3>>();
+    test_bulk_load_with_cache<BPlusTree<int, int, 16, 16, BlockedLayout>>();
+    test_partial_mirror<BPlusTree<int, int, 16, 16>>(2048);
+    test_partial_mirror<BPlusTree<int, int, 8, 8>>(1024);
+
+    if (failures) {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "test_top_cache: ok" << endl;
+    return 0;
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// --- BENCHMARK WORKLOADS ---
+// query and key streams for the benchmarks beyond "every inserted key once, shuffled":
+// skewed popularity (Zipf, hot set), a share of lookups for absent keys, timestamp-like appends
+// and key traces read from a file. Generators work on a population vector that the caller has
+// put in popularity order (shuffle the distinct keys once: rank 0 is then a random key, so hot
+// keys are spread over the whole tree instead of sitting in its first leaves)
+namespace workload
+{
+    enum class Distribution
+    {
+        Uniform, // every population key equally likely
+        Zipf,    // rank r drawn with probability ~ 1 / (r + 1)^zipf_theta
+        HotSet   // hot_access of the draws go to the first hot_fraction of the population
+    };
+
+    struct QuerySpec
+    {
+        Distribution dist = Distribution::Uniform;
+        double zipf_theta = 0.99;  // in [0, 1), YCSB's default skew
+        double hot_fraction = 0.1; // share of the population that is hot
+        double hot_access = 0.9;   // share of the queries that go to the hot keys
+        double miss_ratio = 0;     // share of the queries replaced by keys not in the population
+    };
+
+    // Zipf ranks in [0, n) by the method of Gray et al. (as used by YCSB): O(n) setup for the
+    // zeta constant, then O(1) per draw without tables. theta must lie in [0, 1)
+    class ZipfGenerator
+    {
+        uint64_t n;
+        double theta;
+        double alpha;
+        double zetan;
+        double eta;
+        double half_pow_theta;
+
+        static double zeta(uint64_t count, double theta)
+        {
+            double sum = 0;
+            for (uint64_t i = 1; i <= count; i++)
+                sum += 1.0 / std::pow((double)i, theta);
+            return sum;
+        }
+
+    public:
+        ZipfGenerator(uint64_t items, double skew) : n(items), theta(skew)
+        {
+            if (items == 0)
+                throw std::invalid_argument("ZipfGenerator needs at least one item");
+            if (!(skew >= 0 && skew < 1))
+                throw std::invalid_argument("ZipfGenerator skew must lie in [0, 1)");
+            alpha = 1.0 / (1.0 - theta);
+            zetan = zeta(n, theta);
+            double zeta2 = zeta(std::min<uint64_t>(n, 2), theta);
+            eta = n > 2 ? (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan) : 1.0;
+            half_pow_theta = std::pow(0.5, theta);
+        }
+
+        template <typename Rng>
+        uint64_t next(Rng &gen)
+        {
+            double u = std::uniform_real_distribution<double>(0.0, 1.0)(gen);
+            double uz = u * zetan;
+            if (uz < 1.0)
+                return 0;
+            if (uz < 1.0 + half_pow_theta)
+                return std::min<uint64_t>(1, n - 1);
+            uint64_t rank = (uint64_t)((double)n * std::pow(eta * u - eta + 1.0, alpha));
+            return std::min(rank, n - 1);
+        }
+    };
+
+    // count queries over population (popularity order, see above). Misses are drawn uniformly
+    // from [lo, hi] and rejected while present; when the range is (nearly) full they continue
+    // past hi. Throws std::invalid_argument on an empty population or bad ratios
+    template <typename K, typename Rng>
+    std::vector<K> make_queries(const std::vector<K> &population, size_t count, const QuerySpec &spec,
+                                K lo, K hi, Rng &gen)
+    {
+        if (population.empty())
+            throw std::invalid_argument("make_queries needs a non-empty population");
+        if (!(spec.miss_ratio >= 0 && spec.miss_ratio <= 1) || !(spec.hot_fraction > 0 && spec.hot_fraction <= 1) ||
+            !(spec.hot_access >= 0 && spec.hot_access <= 1))
+            throw std::invalid_argument("make_queries ratios must lie in [0, 1]");
+
+        const uint64_t n = population.size();
+        std::vector<K> present;
+        if (spec.miss_ratio > 0)
+        {
+            present = population;
+            std::sort(present.begin(), present.end());
+        }
+
+        ZipfGenerator zipf(spec.dist == Distribution::Zipf ? n : 1, spec.dist == Distribution::Zipf ? spec.zipf_theta : 0);
+        const uint64_t hot = std::max<uint64_t>(1, (uint64_t)(n * spec.hot_fraction));
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        std::uniform_int_distribution<long long> miss_dist((long long)lo, (long long)hi);
+        long long past_hi = (long long)hi;
+
+        std::vector<K> out(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (spec.miss_ratio > 0 && coin(gen) < spec.miss_ratio)
+            {
+                K key = lo;
+                bool found_absent = false;
+                for (int attempt = 0; attempt < 8 && !found_absent; attempt++)
+                {
+                    key = (K)miss_dist(gen);
+                    found_absent = !std::binary_search(present.begin(), present.end(), key);
+                }
+                if (!found_absent)
+                {
+                    do
+                        key = (K)++past_hi;
+                    while (std::binary_search(present.begin(), present.end(), key));
+                }
+                out[i] = key;
+                continue;
+            }
+
+            uint64_t rank;
+            switch (spec.dist)
+            {
+            case Distribution::Zipf:
+                rank = zipf.next(gen);
+                break;
+            case Distribution::HotSet:
+                if (hot == n || coin(gen) < spec.hot_access)
+                    rank = std::uniform_int_distribution<uint64_t>(0, hot - 1)(gen);
+                else
+                    rank = std::uniform_int_distribution<uint64_t>(hot, n - 1)(gen);
+                break;
+            default:
+                rank = std::uniform_int_distribution<uint64_t>(0, n - 1)(gen);
+                break;
+            }
+            out[i] = population[rank];
+        }
+        return out;
+    }
+
+    // timestamp-like stream: strictly increasing keys starting at start, step apart on average,
+    // each gap jittered by up to +-jitter (jitter < step keeps the stream strictly increasing)
+    template <typename K, typename Rng>
+    std::vector<K> append_stream(size_t count, K start, K step, K jitter, Rng &gen)
+    {
+        if (!(jitter < step))
+            throw std::invalid_argument("append_stream jitter must be smaller than step");
+        std::uniform_int_distribution<long long> jitter_dist(-(long long)jitter, (long long)jitter);
+        std::vector<K> out(count);
+        long long key = (long long)start;
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = (K)key;
+            key += (long long)step + jitter_dist(gen);
+        }
+        return out;
+    }
+
+    // whitespace-separated integer keys, one query per key in file order. Throws
+    // std::runtime_error when the file can't be read or holds no keys
+    template <typename K>
+    std::vector<K> load_trace(const std::string &path)
+    {
+        std::ifstream in(path);
+        if (!in)
+            throw std::runtime_error("cannot open key trace " + path);
+        std::vector<K> out;
+        long long key;
+        while (in >> key)
+            out.push_back((K)key);
+        if (!in.eof())
+            throw std::runtime_error("key trace " + path + " holds a non-integer token");
+        if (out.empty())
+            throw std::runtime_error("key trace " + path + " is empty");
+        return out;
+    }
+}